@@ -5,57 +5,81 @@
 #include <functional> 
 #include <cctype>
 #include <locale>
-#include <fstream>
 #include <string>
+#include <cstring>
 #include <iostream>
 
 #include "string.h"
+#include "mmap.h"
 
 namespace tools
 {
+    // Reads a text file line by line, skipping blank lines and '#' comments.
+    // The file is memory mapped, so the lines returned as StringView point
+    // straight into the mapping and are valid while the Reader is alive.
     class Reader
     {
     public:
         std::string filename;
-        std::ifstream file;
+        MappedFile file;
         std::size_t this_line;
 
         Reader(std::string _filename) :
             filename(_filename),
-            file(_filename.c_str()),
-            this_line(0)
+            file(_filename),
+            this_line(0),
+            cursor(0)
         {
             if (!file.is_open())
                 std::cerr << "Reader: ERROR! Can't read the input file. Is the filename right?" << std::endl;
         };
 
         ~Reader()
-        {
-            if (file.is_open())
-                file.close();
-        };
+        {};
 
-        bool getLine(std::string &str, std::size_t &id)
+        bool getLine(StringView &str, std::size_t &id)
         {
-            std::string s;
-            while (std::getline(file, s))
+            const char *data = file.data();
+            std::size_t size = file.size();
+
+            while (cursor < size)
             {
+                const char *begin = data + cursor;
+                const char *end = (const char*)std::memchr(begin, '\n', size - cursor);
+                std::size_t length = end ? (std::size_t)(end - begin) : size - cursor;
+                cursor += length + 1;
                 this_line++;
+
                 //is valid
-                s = trim(s);
-                if (!s.empty() && !beginsWith(s, "#"))
+                StringView s = trim(StringView(begin, length));
+                if (!s.empty() && s[0] != '#')
                 {
                     str = s;
                     id = this_line;
                     return true;
                 }
             }
-            file.close();
             return false;
         }
+
+        bool getLine(std::string &str, std::size_t &id)
+        {
+            StringView s;
+            if (!getLine(s, id))
+                return false;
+
+            str = s.str();
+            return true;
+        }
+
+    private:
+        std::size_t cursor;
+
+        Reader(const Reader&);
+        Reader& operator=(const Reader&);
     };
 
-    static void wait()
+    inline void wait()
     {
         std::cout << "Press [ENTER] to continue..." << std::endl;
         std::cin.get();
@@ -0,0 +1,144 @@
+#ifndef TOOLS_MMAP_H
+#define TOOLS_MMAP_H
+
+#include <string>
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace tools
+{
+    // Read-only view of a whole file mapped into memory.
+    // The data stays valid until the object is closed or destroyed.
+    class MappedFile
+    {
+    public:
+        MappedFile() :
+            _data(NULL),
+            _size(0),
+            _open(false)
+        {};
+
+        MappedFile(std::string filename) :
+            _data(NULL),
+            _size(0),
+            _open(false)
+        {
+            open(filename);
+        };
+
+        ~MappedFile()
+        {
+            close();
+        };
+
+        bool open(std::string filename)
+        {
+            close();
+
+#ifdef _WIN32
+            HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (file == INVALID_HANDLE_VALUE)
+                return false;
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(file, &size))
+            {
+                CloseHandle(file);
+                return false;
+            }
+
+            _size = (std::size_t)size.QuadPart;
+            if (_size > 0)
+            {
+                HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+                if (mapping)
+                {
+                    _data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                    CloseHandle(mapping);
+                }
+                if (!_data)
+                {
+                    CloseHandle(file);
+                    _size = 0;
+                    return false;
+                }
+            }
+            CloseHandle(file);
+#else
+            int fd = ::open(filename.c_str(), O_RDONLY);
+            if (fd < 0)
+                return false;
+
+            struct stat st;
+            if (fstat(fd, &st) != 0)
+            {
+                ::close(fd);
+                return false;
+            }
+
+            _size = (std::size_t)st.st_size;
+            if (_size > 0)
+            {
+                void *ptr = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (ptr == MAP_FAILED)
+                {
+                    ::close(fd);
+                    _size = 0;
+                    return false;
+                }
+                madvise(ptr, _size, MADV_SEQUENTIAL);
+                _data = (const char*)ptr;
+            }
+            ::close(fd);
+#endif
+            _open = true;
+            return true;
+        }
+
+        void close()
+        {
+            if (_data)
+            {
+#ifdef _WIN32
+                UnmapViewOfFile(_data);
+#else
+                munmap((void*)_data, _size);
+#endif
+            }
+            _data = NULL;
+            _size = 0;
+            _open = false;
+        }
+
+        bool is_open() const { return _open; }
+        const char* data() const { return _data; }
+        std::size_t size() const { return _size; }
+
+    private:
+        const char
+            *_data;
+        std::size_t
+            _size;
+        bool
+            _open;
+
+        // non-copyable, the mapping is owned by this object
+        MappedFile(const MappedFile&);
+        MappedFile& operator=(const MappedFile&);
+    };
+}
+
+#endif
@@ -0,0 +1,226 @@
+#ifndef TOOLS_SNAPSHOT_H
+#define TOOLS_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+#include "string.h"
+#include "mmap.h"
+
+namespace tools
+{
+    // Binary snapshots of a parsed input file.
+    //
+    // A snapshot is stored next to the input as "{input}.snap" and is only
+    // used if it was produced from exactly the same source text: the header
+    // records the size and checksum of the text it was built from.
+    //
+    // Layout (native byte order, checked with a marker):
+    //   SnapshotHeader
+    //   payload: a sequence of POD values and strings (u32 length + bytes)
+    //
+    // Bump SNAPSHOT_VERSION whenever the payload of any solver changes.
+    static const uint32_t SNAPSHOT_MAGIC = 0x50414E53; // "SNAP"
+    static const uint32_t SNAPSHOT_VERSION = 3;
+    static const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+    struct SnapshotHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t kind;           // which solver wrote it
+        uint64_t source_size;
+        uint64_t source_checksum;
+        uint64_t payload_size;
+        uint64_t payload_checksum;
+    };
+
+    // 64 bit FNV-1a
+    static inline uint64_t checksum(const char *data, std::size_t size)
+    {
+        uint64_t h = 14695981039346656037ULL;
+        for (std::size_t i = 0; i < size; i++)
+        {
+            h ^= (unsigned char)data[i];
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    static inline std::string snapshotName(std::string filename)
+    {
+        return filename + ".snap";
+    }
+
+    class SnapshotWriter
+    {
+    public:
+        SnapshotWriter(uint32_t kind) :
+            _kind(kind)
+        {};
+
+        void write(const void *data, std::size_t size)
+        {
+            const char *p = (const char*)data;
+            buffer.insert(buffer.end(), p, p + size);
+        }
+
+        // Only for plain data types (integers, doubles, enums...)
+        template <typename T>
+        void put(const T &v)
+        {
+            write(&v, sizeof(T));
+        }
+
+        void put(StringView s)
+        {
+            uint32_t size = (uint32_t)s.size();
+            put(size);
+            write(s.data(), s.size());
+        }
+
+        void put(const std::string &s)
+        {
+            put(StringView(s));
+        }
+
+        // Writes the snapshot for {source} into {filename}. The file is
+        // written aside and renamed, so readers never see half a snapshot.
+        bool save(std::string filename, StringView source)
+        {
+            SnapshotHeader h;
+            h.magic = SNAPSHOT_MAGIC;
+            h.version = SNAPSHOT_VERSION;
+            h.byte_order = SNAPSHOT_BYTE_ORDER;
+            h.kind = _kind;
+            h.source_size = source.size();
+            h.source_checksum = checksum(source.data(), source.size());
+            h.payload_size = buffer.size();
+            h.payload_checksum = checksum(buffer.empty() ? NULL : &buffer[0], buffer.size());
+
+            std::string tmp = filename + ".tmp";
+            {
+                std::ofstream out(tmp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+                if (!out.is_open())
+                    return false;
+
+                out.write((const char*)&h, sizeof(h));
+                if (!buffer.empty())
+                    out.write(&buffer[0], buffer.size());
+                if (!out.good())
+                {
+                    out.close();
+                    std::remove(tmp.c_str());
+                    return false;
+                }
+            }
+
+            std::remove(filename.c_str());
+            if (std::rename(tmp.c_str(), filename.c_str()) != 0)
+            {
+                std::remove(tmp.c_str());
+                return false;
+            }
+            return true;
+        }
+
+    private:
+        uint32_t
+            _kind;
+        std::vector<char>
+            buffer;
+    };
+
+    class SnapshotReader
+    {
+    public:
+        // Maps {filename} and checks it was written by {kind} from {source}.
+        SnapshotReader(std::string filename, uint32_t kind, StringView source) :
+            cursor(0),
+            end(0),
+            valid(false)
+        {
+            if (!file.open(filename) || file.size() < sizeof(SnapshotHeader))
+                return;
+
+            SnapshotHeader h;
+            std::memcpy(&h, file.data(), sizeof(h));
+
+            if (h.magic != SNAPSHOT_MAGIC ||
+                h.version != SNAPSHOT_VERSION ||
+                h.byte_order != SNAPSHOT_BYTE_ORDER ||
+                h.kind != kind ||
+                h.payload_size != file.size() - sizeof(SnapshotHeader) ||
+                h.source_size != source.size())
+                return;
+
+            const char *payload = file.data() + sizeof(SnapshotHeader);
+            if (h.payload_checksum != checksum(payload, (std::size_t)h.payload_size))
+                return;
+            if (h.source_checksum != checksum(source.data(), source.size()))
+                return;
+
+            cursor = sizeof(SnapshotHeader);
+            end = file.size();
+            valid = true;
+        };
+
+        bool is_valid() const { return valid; }
+
+        // true once every byte of the payload has been read
+        bool done() const { return valid && cursor == end; }
+
+        bool read(void *data, std::size_t size)
+        {
+            if (!valid || size > end - cursor)
+                return valid = false;
+
+            std::memcpy(data, file.data() + cursor, size);
+            cursor += size;
+            return true;
+        }
+
+        template <typename T>
+        bool get(T &v)
+        {
+            return read(&v, sizeof(T));
+        }
+
+        // The view points into the mapped snapshot (no copy)
+        bool get(StringView &s)
+        {
+            uint32_t size;
+            if (!get(size) || size > end - cursor)
+                return valid = false;
+
+            s = StringView(file.data() + cursor, size);
+            cursor += size;
+            return true;
+        }
+
+        bool get(std::string &s)
+        {
+            StringView v;
+            if (!get(v))
+                return false;
+            s.assign(v.data(), v.size());
+            return true;
+        }
+
+    private:
+        MappedFile
+            file;
+        std::size_t
+            cursor,
+            end;
+        bool
+            valid;
+    };
+}
+
+#endif
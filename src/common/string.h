@@ -8,15 +8,133 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <ostream>
 
 namespace tools
 {
+    // Non-owning reference to a run of characters (pointer + length).
+    // It never allocates; the referenced memory must outlive the view.
+    class StringView
+    {
+    public:
+        typedef const char* iterator;
+        typedef const char* const_iterator;
+        static const std::size_t npos = static_cast<std::size_t>(-1);
+
+        StringView() :
+            _data(NULL),
+            _size(0)
+        {};
+
+        StringView(const char *data, std::size_t size) :
+            _data(data),
+            _size(size)
+        {};
+
+        StringView(const char *str) :
+            _data(str),
+            _size(str ? std::strlen(str) : 0)
+        {};
+
+        StringView(const std::string &str) :
+            _data(str.data()),
+            _size(str.size())
+        {};
+
+        const char* data() const { return _data; }
+        std::size_t size() const { return _size; }
+        std::size_t length() const { return _size; }
+        bool empty() const { return _size == 0; }
+
+        const_iterator begin() const { return _data; }
+        const_iterator end() const { return _data + _size; }
+
+        char operator[](std::size_t i) const { return _data[i]; }
+        char front() const { return _data[0]; }
+        char back() const { return _data[_size - 1]; }
+
+        void remove_prefix(std::size_t n) { _data += n; _size -= n; }
+        void remove_suffix(std::size_t n) { _size -= n; }
+
+        StringView substr(std::size_t pos, std::size_t count = npos) const
+        {
+            if (pos > _size) pos = _size;
+            if (count > _size - pos) count = _size - pos;
+            return StringView(_data + pos, count);
+        }
+
+        std::size_t find(char c, std::size_t pos = 0) const
+        {
+            if (pos >= _size) return npos;
+            const void *p = std::memchr(_data + pos, c, _size - pos);
+            return p ? (const char*)p - _data : npos;
+        }
+
+        std::size_t find(StringView s, std::size_t pos = 0) const
+        {
+            if (s._size == 1) return find(s._data[0], pos);
+            if (s._size == 0) return pos <= _size ? pos : npos;
+            while (pos + s._size <= _size)
+            {
+                std::size_t k = find(s._data[0], pos);
+                if (k == npos || k + s._size > _size) return npos;
+                if (std::memcmp(_data + k, s._data, s._size) == 0) return k;
+                pos = k + 1;
+            }
+            return npos;
+        }
+
+        int compare(StringView s) const
+        {
+            std::size_t n = _size < s._size ? _size : s._size;
+            int r = n ? std::memcmp(_data, s._data, n) : 0;
+            if (r != 0) return r;
+            return _size < s._size ? -1 : (_size > s._size ? 1 : 0);
+        }
+
+        std::string str() const { return std::string(_data, _size); }
+
+    private:
+        const char
+            *_data;
+        std::size_t
+            _size;
+    };
+
+    static inline bool operator==(StringView a, StringView b) { return a.compare(b) == 0; }
+    static inline bool operator!=(StringView a, StringView b) { return a.compare(b) != 0; }
+    static inline bool operator<(StringView a, StringView b) { return a.compare(b) < 0; }
+
+    static inline std::ostream& operator<<(std::ostream &os, StringView s)
+    {
+        return os.write(s.data(), s.size());
+    }
+
     //checks if a string {str} is prefixed with {prefix}
     static inline bool beginsWith(std::string str, std::string prefix)
     {
         return std::mismatch(prefix.begin(), prefix.end(), str.begin()).first == prefix.end();
     }
 
+    static inline bool beginsWith(StringView str, StringView prefix)
+    {
+        return str.size() >= prefix.size() && std::memcmp(str.data(), prefix.data(), prefix.size()) == 0;
+    }
+
+    // case insensitive comparison, used for the [section] headers
+    static inline bool iequals(StringView a, StringView b)
+    {
+        if (a.size() != b.size()) return false;
+        for (std::size_t i = 0; i < a.size(); i++)
+        {
+            if (std::tolower((unsigned char)a[i]) != std::tolower((unsigned char)b[i]))
+                return false;
+        }
+        return true;
+    }
+
     // trim from start
     static inline std::string &ltrim(std::string &s)
     {
@@ -37,25 +155,165 @@ namespace tools
         return ltrim(rtrim(s));
     }
 
-    static inline std::vector<std::string> split(std::string str, std::string delimiter)
+    // trim from both ends, without copying
+    static inline StringView trim(StringView s)
     {
-        std::vector<std::string> tokens;
+        std::size_t b = 0, e = s.size();
+        while (b < e && std::isspace((unsigned char)s[b])) b++;
+        while (e > b && std::isspace((unsigned char)s[e - 1])) e--;
+        return s.substr(b, e - b);
+    }
+
+    // Splits a string on {delimiter} without copying or allocating.
+    // Tokens are produced lazily as trimmed views into the original string;
+    // empty tokens (two delimiters in a row) are skipped.
+    //
+    //   for (Tokenizer::iterator t = tok.begin(); t != tok.end(); ++t) use(*t);
+    class Tokenizer
+    {
+    public:
+        class iterator
+        {
+        public:
+            iterator() :
+                _owner(NULL),
+                _pos(StringView::npos)
+            {};
+
+            const StringView& operator*() const { return _token; }
+            const StringView* operator->() const { return &_token; }
+
+            iterator& operator++()
+            {
+                advance();
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator it = *this;
+                advance();
+                return it;
+            }
+
+            bool operator==(const iterator &it) const { return _pos == it._pos; }
+            bool operator!=(const iterator &it) const { return _pos != it._pos; }
+
+        private:
+            friend class Tokenizer;
+
+            const Tokenizer *_owner;
+            std::size_t _pos; // start of the next raw token, npos at the end
+            StringView _token;
+
+            iterator(const Tokenizer *owner) :
+                _owner(owner),
+                _pos(0)
+            {
+                advance();
+            };
+
+            void advance()
+            {
+                const StringView &str = _owner->_str;
+                const StringView &del = _owner->_delimiter;
+
+                while (_pos != StringView::npos && _pos < str.size())
+                {
+                    std::size_t next = del.empty() ? StringView::npos : str.find(del, _pos);
+                    std::size_t end = next == StringView::npos ? str.size() : next;
+
+                    StringView raw = str.substr(_pos, end - _pos);
+                    _pos = next == StringView::npos ? str.size() : next + del.size();
+
+                    if (!raw.empty())
+                    {
+                        _token = trim(raw);
+                        return;
+                    }
+                }
+                _pos = StringView::npos;
+                _token = StringView();
+            }
+        };
+
+        typedef iterator const_iterator;
+
+        Tokenizer(StringView str, StringView delimiter) :
+            _str(str),
+            _delimiter(delimiter)
+        {};
 
-        std::size_t pos = 0;
-        std::string token;
-        while ((pos = str.find(delimiter)) != std::string::npos)
+        iterator begin() const { return iterator(this); }
+        iterator end() const { return iterator(); }
+
+        std::size_t count() const
+        {
+            std::size_t n = 0;
+            for (iterator it = begin(); it != end(); ++it) n++;
+            return n;
+        }
+
+    private:
+        StringView
+            _str,
+            _delimiter;
+    };
+
+    // Fills up to {max} tokens of {str} into {tokens} and returns how many
+    // tokens the string has in total (which may be more than {max}).
+    static inline std::size_t split(StringView str, StringView delimiter, StringView *tokens, std::size_t max)
+    {
+        Tokenizer tok(str, delimiter);
+        std::size_t n = 0;
+        for (Tokenizer::iterator it = tok.begin(); it != tok.end(); ++it, n++)
         {
-            token = str.substr(0, pos);
-            if (!token.empty())
-                tokens.push_back(trim(token));
-            str.erase(0, pos + delimiter.length());
+            if (n < max) tokens[n] = *it;
         }
-        if (!str.empty())
-            tokens.push_back(trim(str));
+        return n;
+    }
+
+    static inline std::vector<std::string> split(StringView str, StringView delimiter)
+    {
+        std::vector<std::string> tokens;
+
+        Tokenizer tok(str, delimiter);
+        for (Tokenizer::iterator it = tok.begin(); it != tok.end(); ++it)
+            tokens.push_back(it->str());
 
         return tokens;
     }
 
+    // Number parsing straight from a view (the view is not null terminated).
+    // Returns false and leaves {v} as 0 if the text is not a number.
+    static inline bool parse(StringView s, double &v)
+    {
+        char buffer[64];
+        v = 0;
+        if (s.empty() || s.size() >= sizeof(buffer)) return false;
+
+        std::memcpy(buffer, s.data(), s.size());
+        buffer[s.size()] = '\0';
+
+        char *end = NULL;
+        v = std::strtod(buffer, &end);
+        return end == buffer + s.size();
+    }
+
+    static inline bool parse(StringView s, int &v)
+    {
+        char buffer[32];
+        v = 0;
+        if (s.empty() || s.size() >= sizeof(buffer)) return false;
+
+        std::memcpy(buffer, s.data(), s.size());
+        buffer[s.size()] = '\0';
+
+        char *end = NULL;
+        v = (int)std::strtol(buffer, &end, 10);
+        return end == buffer + s.size();
+    }
+
     static inline bool match(std::string str, std::string pattern, unsigned int offset = 0)
     {
         unsigned int i = 0;
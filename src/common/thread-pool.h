@@ -0,0 +1,133 @@
+#ifndef TOOLS_THREAD_POOL_H
+#define TOOLS_THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace tools
+{
+    // A fixed set of worker threads that run one job at a time.
+    //
+    // The threads are started once and wait between jobs, so a job can be
+    // handed out thousands of times (e.g. once per iteration of an
+    // algorithm) without paying for thread creation. A job is split into
+    // size() parts; the calling thread runs part 0 and run() returns when
+    // every part is done.
+    //
+    // Needs C++11 (-std=c++11 -pthread with GCC).
+    class ThreadPool
+    {
+    public:
+        class Job
+        {
+        public:
+            virtual ~Job() {}
+
+            // Does part {part} of {parts}
+            virtual void run(unsigned int part, unsigned int parts) = 0;
+        };
+
+        // {threads} counts the calling thread; 0 means one per hardware thread
+        ThreadPool(unsigned int threads = 0) :
+            _job(NULL),
+            _generation(0),
+            _pending(0),
+            _stopping(false)
+        {
+            if (threads == 0)
+                threads = std::thread::hardware_concurrency();
+            if (threads == 0)
+                threads = 1;
+
+            for (unsigned int part = 1; part < threads; part++)
+                _workers.push_back(std::thread(&ThreadPool::work, this, part));
+        };
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                _stopping = true;
+            }
+            _wake.notify_all();
+
+            for (unsigned int i = 0; i < _workers.size(); i++)
+                _workers[i].join();
+        };
+
+        unsigned int size() const { return (unsigned int)_workers.size() + 1; }
+
+        void run(Job &job)
+        {
+            if (_workers.empty())
+            {
+                job.run(0, 1);
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                _job = &job;
+                _pending = (unsigned int)_workers.size();
+                _generation++;
+            }
+            _wake.notify_all();
+
+            job.run(0, size());
+
+            std::unique_lock<std::mutex> guard(_lock);
+            while (_pending > 0)
+                _finished.wait(guard);
+            _job = NULL;
+        }
+
+    private:
+        std::vector<std::thread>
+            _workers;
+        std::mutex
+            _lock;
+        std::condition_variable
+            _wake,
+            _finished;
+        Job
+            *_job;
+        unsigned long
+            _generation;    // jobs handed out so far
+        unsigned int
+            _pending;       // workers still busy with the current job
+        bool
+            _stopping;
+
+        ThreadPool(const ThreadPool &);
+        ThreadPool& operator=(const ThreadPool &);
+
+        void work(unsigned int part)
+        {
+            unsigned long seen = 0;
+            for (;;)
+            {
+                Job *job;
+                {
+                    std::unique_lock<std::mutex> guard(_lock);
+                    while (!_stopping && _generation == seen)
+                        _wake.wait(guard);
+                    if (_stopping)
+                        return;
+
+                    seen = _generation;
+                    job = _job;
+                }
+
+                job->run(part, size());
+
+                std::lock_guard<std::mutex> guard(_lock);
+                if (--_pending == 0)
+                    _finished.notify_one();
+            }
+        }
+    };
+}
+
+#endif
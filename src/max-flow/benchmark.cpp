@@ -0,0 +1,266 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include <ctime>
+#include "lib/graph.hpp"
+#include "lib/dinic.hpp"
+#include "lib/push-relabel.hpp"
+#include "lib/grid-graph.hpp"
+#include "lib/boykov-kolmogorov.hpp"
+
+using namespace std;
+
+// Compares the max-flow engines on synthetic layered networks of growing
+// size: {s} -> layer 0 -> ... -> layer L-1 -> {t}, where every vertex is
+// linked to a few random vertices of the next layer.
+//
+// Then times Boykov-Kolmogorov on segmentation grids up to 4K, the small
+// ones checked against Dinic on the same graph spelled out as a TGraph.
+//
+//   ./max-flow-benchmark [max width = 128]
+
+static unsigned int lcg_state = 12345;
+
+// small portable generator, so every platform builds the same graphs
+static unsigned int next_random(unsigned int n)
+{
+    lcg_state = lcg_state * 1103515245u + 12345u;
+    return (lcg_state >> 8) % n;
+}
+
+static string name(int layer, int i)
+{
+    stringstream ss;
+    ss << "v" << layer << "_" << i;
+    return ss.str();
+}
+
+static void layered(Graph &graph, int layers, int width, int degree)
+{
+    lcg_state = 12345;
+
+    int s = graph.addVertex("s");
+    int t = graph.addVertex("t");
+
+    vector<int> prev, layer(width);
+    for (int l = 0; l < layers; l++)
+    {
+        for (int i = 0; i < width; i++)
+            layer[i] = graph.addVertex(name(l, i));
+
+        for (int i = 0; i < width; i++)
+        {
+            if (l == 0)
+            {
+                graph.addEdge(s, "s", layer[i], name(l, i), 50 + next_random(100));
+                continue;
+            }
+            for (int d = 0; d < degree; d++)
+            {
+                int j = next_random(width);
+                graph.addEdge(prev[j], name(l - 1, j), layer[i], name(l, i), 1 + next_random(100));
+            }
+        }
+        prev = layer;
+    }
+
+    for (int i = 0; i < width; i++)
+        graph.addEdge(prev[i], name(layers - 1, i), t, "t", 50 + next_random(100));
+
+    graph.freeze();
+}
+
+static Graph::Capacity augmentingPaths(Graph &graph)
+{
+    Graph::Capacity flow = 0;
+
+    Graph::Path p = graph.findPath("s", "t");
+    while (p.isValid())
+    {
+        Graph::Capacity c = p.findMaxCapacity();
+        flow += c;
+        graph.augment(p, c);
+        p = graph.findPath("s", "t");
+    }
+    return flow;
+}
+
+static Graph::Capacity dinic(Graph &graph)
+{
+    Dinic engine(graph);
+    return engine.solve("s", "t");
+}
+
+static Graph::Capacity fifo(Graph &graph)
+{
+    PushRelabel engine(graph, PushRelabel::FIFO);
+    return engine.solve("s", "t");
+}
+
+static Graph::Capacity highestLabel(Graph &graph)
+{
+    PushRelabel engine(graph, PushRelabel::HIGHEST_LABEL);
+    return engine.solve("s", "t");
+}
+
+// Foreground / background cut of a noisy synthetic image (a bright disc
+// on a dark background). If {expanded} is given, the same graph is also
+// built there with explicit vertices.
+static void segmentation(GridGraph &grid, Graph *expanded)
+{
+    lcg_state = 12345;
+
+    int w = grid.width(), h = grid.height();
+    vector<int> image(w * h);
+    for (int y = 0; y < h; y++)
+    {
+        for (int x = 0; x < w; x++)
+        {
+            int
+                dx = x - w / 2,
+                dy = y - h / 2,
+                r = min(w, h) / 3;
+            image[grid.vertex(x, y)] = (dx * dx + dy * dy < r * r ? 180 : 70) + (int)next_random(81) - 40;
+        }
+    }
+
+    if (expanded)
+    {
+        expanded->addVertex("s");
+        expanded->addVertex("t");
+        for (int v = 0; v < grid.countVertex(); v++)
+            expanded->addVertex(name(0, v));
+    }
+
+    for (int v = 0; v < grid.countVertex(); v++)
+    {
+        // cost of labelling {v} background (kept by the s link) and
+        // foreground (kept by the t link)
+        unsigned int
+            background = abs(image[v] - 70),
+            foreground = abs(image[v] - 180);
+        grid.setTerminals(v, background, foreground);
+
+        if (expanded)
+        {
+            expanded->addEdge(0, "s", v + 2, name(0, v), background);
+            expanded->addEdge(v + 2, name(0, v), 1, "t", foreground);
+        }
+
+        // smoothness: similar neighbours are expensive to separate
+        for (int k = 0; k < grid.countDirections(); k += 2)
+        {
+            int u = grid.neighbour(v, k);
+            if (u < 0)
+                continue;
+
+            unsigned int c = 600 / (10 + abs(image[v] - image[u]));
+            grid.setEdge(v, k, c, c);
+
+            if (expanded)
+            {
+                // the paired edge u -> v holds the capacity back
+                expanded->addEdge(v + 2, name(0, v), u + 2, name(0, u), c);
+                expanded->getEdge(u + 2, v + 2)->weight = c;
+            }
+        }
+    }
+
+    if (expanded)
+        expanded->freeze();
+}
+
+typedef Graph::Capacity (*Solver)(Graph &graph);
+
+// runs {solver} on a copy of {graph}, prints the time in seconds
+static Graph::Capacity run(Solver solver, const Graph &graph)
+{
+    Graph g(graph);
+
+    clock_t start = clock();
+    Graph::Capacity flow = solver(g);
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    cout << setw(14) << fixed << setprecision(3) << seconds;
+    return flow;
+}
+
+int main(int argc, char *argv[])
+{
+    int max_width = argc > 1 ? atoi(argv[1]) : 128;
+
+    cout
+        << setw(10) << "vertices"
+        << setw(10) << "edges"
+        << setw(14) << "augmenting"
+        << setw(14) << "dinic"
+        << setw(14) << "fifo p-r"
+        << setw(14) << "highest p-r"
+        << setw(10) << "flow"
+        << "\n";
+
+    for (int width = 16; width <= max_width; width *= 2)
+    {
+        Graph graph;
+        layered(graph, width, width, 4);
+
+        cout
+            << setw(10) << graph.countVertex()
+            << setw(10) << graph.countEdges() / 2;
+
+        Graph::Capacity
+            f1 = run(augmentingPaths, graph),
+            f2 = run(dinic, graph),
+            f3 = run(fifo, graph),
+            f4 = run(highestLabel, graph);
+
+        cout << setw(10) << f1;
+        if (f1 != f2 || f1 != f3 || f1 != f4)
+            cout << "  MISMATCH: " << f2 << " " << f3 << " " << f4;
+        cout << endl;
+    }
+
+    cout
+        << "\n"
+        << setw(12) << "grid"
+        << setw(14) << "b-k"
+        << setw(14) << "dinic"
+        << setw(10) << "flow"
+        << "\n";
+
+    int sizes[][2] = { { 64, 64 }, { 256, 256 }, { 640, 480 }, { 1920, 1080 }, { 3840, 2160 } };
+    for (unsigned int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        int w = sizes[i][0], h = sizes[i][1];
+        bool check = w * h <= 256 * 256;
+
+        GridGraph grid(w, h);
+        Graph expanded;
+        segmentation(grid, check ? &expanded : NULL);
+
+        stringstream size;
+        size << w << "x" << h;
+        cout << setw(12) << size.str();
+
+        BoykovKolmogorov bk(grid);
+        clock_t start = clock();
+        Graph::Capacity f1 = bk.solve();
+        cout << setw(14) << fixed << setprecision(3) << (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        if (check)
+        {
+            Graph::Capacity f2 = run(dinic, expanded);
+            cout << setw(10) << f1;
+            if (f1 != f2)
+                cout << "  MISMATCH: " << f2;
+        }
+        else
+        {
+            cout << setw(14) << "-" << setw(10) << f1;
+        }
+        cout << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,377 @@
+#ifndef BOYKOV_KOLMOGOROV_H
+#define BOYKOV_KOLMOGOROV_H
+
+#include <vector>
+#include <deque>
+
+#include "grid-graph.hpp"
+
+// Boykov-Kolmogorov max-flow on a TGridGraph.
+//
+// Two search trees are grown, one from the source and one from the sink,
+// over edges with residual capacity. When they touch, the path through the
+// touching edge is augmented; the edges it saturates cut some vertices off
+// their tree (the orphans), which then look for a new parent among their
+// neighbours in the same tree or become free. The trees are kept between
+// augmentations instead of being searched again from scratch, which is
+// what makes the method fast on the short, wide paths of grid graphs.
+//
+// The flow is pushed on the grid itself: after solve() the capacities are
+// residual and segment() tells on which side of the minimum cut each
+// vertex falls.
+template <class TWeight = unsigned int>
+class TBoykovKolmogorov
+{
+public:
+    typedef TGridGraph<TWeight> Graph;
+    typedef typename Graph::Capacity Capacity;
+
+    enum Tree
+    {
+        FREE,
+        SOURCE,
+        SINK
+    };
+
+    unsigned int
+        augmentations,  // paths pushed by the last solve()
+        adoptions;      // orphans given a new parent by the last solve()
+
+    TBoykovKolmogorov(Graph &_graph) :
+        augmentations(0),
+        adoptions(0),
+        graph(_graph)
+    {};
+
+    // Returns the total flow of the grid, including what setTerminals()
+    // pushed through the terminal links.
+    Capacity solve()
+    {
+        augmentations = adoptions = 0;
+
+        n = graph.n;
+        directions = graph.countDirections();
+        offset = &graph.offset[0];
+
+        tree.assign(n, FREE);
+        parent.assign(n, NONE);
+        active.assign(n, 0);
+        ts.assign(n, 0);
+        dist.assign(n, 0);
+        queue.clear();
+        orphans.clear();
+        time = 0;
+
+        for (int v = 0; v < n; v++)
+        {
+            if (graph.source_cap[v] > 0)
+                tree[v] = SOURCE;
+            else if (graph.sink_cap[v] > 0)
+                tree[v] = SINK;
+            else
+                continue;
+
+            parent[v] = TERMINAL;
+            dist[v] = 1;
+            activate(v);
+        }
+
+        int from, dir;
+        while (grow(from, dir))
+        {
+            time++;
+            graph.pushed += augment(from, dir);
+            augmentations++;
+            adopt();
+        }
+
+        return graph.pushed;
+    }
+
+    // Side of the minimum cut of {v} after solve(): vertices still
+    // reachable from the source are SOURCE, everything else is SINK
+    Tree segment(int v) const
+    {
+        return tree[v] == SOURCE ? SOURCE : SINK;
+    }
+
+private:
+    enum
+    {
+        TERMINAL = -1,  // parent links of the vertices linked to a terminal
+        ORPHAN = -2,
+        NONE = -3,      // free vertex
+        INFINITE = 0x7FFFFFFF
+    };
+
+    Graph
+        &graph;
+    int
+        n,
+        directions,
+        time;       // number of augmentations, for the distance stamps
+    const int
+        *offset;
+    std::vector < unsigned char >
+        tree;
+    std::vector < signed char >
+        parent;     // direction of the parent (or TERMINAL, ORPHAN, NONE)
+    std::vector < char >
+        active;
+    std::vector < int >
+        ts,         // time at which dist was known to be right
+        dist,       // edges to the terminal along the parents
+        orphans;
+    std::deque < int >
+        queue;      // active vertices, can hold free ones
+
+    TWeight& cap(int v, int dir)
+    {
+        return graph.cap[(std::size_t)dir * n + v];
+    }
+
+    bool inside(int v)
+    {
+        return (unsigned int)v < (unsigned int)n;
+    }
+
+    void activate(int v)
+    {
+        if (active[v])
+            return;
+
+        active[v] = 1;
+        queue.push_back(v);
+    }
+
+    void orphan(int v)
+    {
+        parent[v] = ORPHAN;
+        orphans.push_back(v);
+    }
+
+    // Grows the trees from the active vertices until they touch. The
+    // touching edge is returned as {from} (in the source tree) and the
+    // direction to its end (in the sink tree).
+    //
+    // Neighbour ids that fall outside the grid are skipped; the ones that
+    // wrap around a row are not real edges, but their capacity is 0 in
+    // both directions, so they are never followed.
+    bool grow(int &from, int &dir)
+    {
+        while (!queue.empty())
+        {
+            int p = queue.front();
+            if (tree[p] != FREE)
+            {
+                bool source = tree[p] == SOURCE;
+                for (int k = 0; k < directions; k++)
+                {
+                    int q = p + offset[k];
+                    if (!inside(q))
+                        continue;
+
+                    TWeight r = source ? cap(p, k) : cap(q, Graph::opposite(k));
+                    if (!(r > 0))
+                        continue;
+
+                    if (tree[q] == FREE)
+                    {
+                        tree[q] = tree[p];
+                        parent[q] = (signed char)Graph::opposite(k);
+                        ts[q] = ts[p];
+                        dist[q] = dist[p] + 1;
+                        activate(q);
+                    }
+                    else if (tree[q] != tree[p])
+                    {
+                        from = source ? p : q;
+                        dir = source ? k : Graph::opposite(k);
+                        return true;    // {p} stays active
+                    }
+                    else if (ts[q] <= ts[p] && dist[q] > dist[p])
+                    {
+                        // {q} is closer to the terminal through {p}
+                        parent[q] = (signed char)Graph::opposite(k);
+                        ts[q] = ts[p];
+                        dist[q] = dist[p] + 1;
+                    }
+                }
+            }
+
+            active[p] = 0;
+            queue.pop_front();
+        }
+
+        return false;
+    }
+
+    // Pushes the bottleneck along source -> ... -> from -> to -> ... -> sink
+    // and makes orphans of the vertices whose parent edge is saturated.
+    TWeight augment(int from, int dir)
+    {
+        int to = from + offset[dir];
+
+        TWeight c = cap(from, dir);
+        int v;
+        for (v = from; parent[v] != TERMINAL; v += offset[parent[v]])
+        {
+            TWeight r = cap(v + offset[parent[v]], Graph::opposite(parent[v]));
+            if (r < c)
+                c = r;
+        }
+        if (graph.source_cap[v] < c)
+            c = graph.source_cap[v];
+
+        for (v = to; parent[v] != TERMINAL; v += offset[parent[v]])
+        {
+            TWeight r = cap(v, parent[v]);
+            if (r < c)
+                c = r;
+        }
+        if (graph.sink_cap[v] < c)
+            c = graph.sink_cap[v];
+
+        cap(from, dir) -= c;
+        cap(to, Graph::opposite(dir)) += c;
+
+        for (v = from; ; )
+        {
+            int k = parent[v];
+            if (k == TERMINAL)
+            {
+                graph.source_cap[v] -= c;
+                if (!(graph.source_cap[v] > 0))
+                    orphan(v);
+                break;
+            }
+
+            int u = v + offset[k];
+            cap(u, Graph::opposite(k)) -= c;
+            cap(v, k) += c;
+            if (!(cap(u, Graph::opposite(k)) > 0))
+                orphan(v);
+            v = u;
+        }
+
+        for (v = to; ; )
+        {
+            int k = parent[v];
+            if (k == TERMINAL)
+            {
+                graph.sink_cap[v] -= c;
+                if (!(graph.sink_cap[v] > 0))
+                    orphan(v);
+                break;
+            }
+
+            int u = v + offset[k];
+            cap(v, k) -= c;
+            cap(u, Graph::opposite(k)) += c;
+            if (!(cap(v, k) > 0))
+                orphan(v);
+            v = u;
+        }
+
+        return c;
+    }
+
+    // Residual capacity of the edge that would make {q} the parent of {v}
+    TWeight parentCapacity(int v, int k, int q)
+    {
+        return tree[v] == SOURCE ? cap(q, Graph::opposite(k)) : cap(v, k);
+    }
+
+    // Distance of {q} to its terminal, INFINITE if an orphan is on the way.
+    // The vertices on a valid path are stamped with the current time.
+    int origin(int q)
+    {
+        int d = 0;
+        int j = q;
+        for (;;)
+        {
+            if (ts[j] == time)
+            {
+                d += dist[j];
+                break;
+            }
+
+            int k = parent[j];
+            d++;
+            if (k == TERMINAL)
+            {
+                ts[j] = time;
+                dist[j] = 1;
+                break;
+            }
+            if (k == ORPHAN)
+                return INFINITE;
+
+            j += offset[k];
+        }
+
+        int result = d;
+        for (j = q; ts[j] != time; j += offset[parent[j]])
+        {
+            ts[j] = time;
+            dist[j] = d--;
+        }
+        return result;
+    }
+
+    void adopt()
+    {
+        while (!orphans.empty())
+        {
+            int v = orphans.back();
+            orphans.pop_back();
+
+            // the closest neighbour in the same tree still linked to the terminal
+            int best = NONE, d_min = INFINITE;
+            for (int k = 0; k < directions; k++)
+            {
+                int q = v + offset[k];
+                if (!inside(q) || tree[q] != tree[v] || !(parentCapacity(v, k, q) > 0))
+                    continue;
+
+                int d = origin(q);
+                if (d < d_min)
+                {
+                    best = k;
+                    d_min = d;
+                }
+            }
+
+            if (best != NONE)
+            {
+                parent[v] = (signed char)best;
+                ts[v] = time;
+                dist[v] = d_min + 1;
+                adoptions++;
+                continue;
+            }
+
+            // no parent: {v} leaves the tree, taking its children along
+            for (int k = 0; k < directions; k++)
+            {
+                int q = v + offset[k];
+                if (!inside(q) || tree[q] != tree[v])
+                    continue;
+
+                if (parentCapacity(v, k, q) > 0)
+                    activate(q);
+
+                int a = parent[q];
+                if (a >= 0 && q + offset[a] == v)
+                    orphan(q);
+            }
+
+            tree[v] = FREE;
+            parent[v] = NONE;
+        }
+    }
+};
+
+typedef TBoykovKolmogorov<unsigned int> BoykovKolmogorov;
+
+#endif
@@ -0,0 +1,174 @@
+#ifndef DINIC_H
+#define DINIC_H
+
+#include <vector>
+#include <string>
+
+#include "graph.hpp"
+
+// Dinic's max-flow algorithm on the residual edges of a TGraph.
+//
+// Each phase builds a level graph with a breadth-first search from the
+// source and then saturates it with a blocking flow, found by depth-first
+// searches that remember the next edge to try on every vertex (the current
+// arc), so every edge is discarded at most once per phase.
+//
+// The flow is pushed on the graph itself: after solve() the edges hold the
+// final residual capacities, and TGraph::print() shows them as usual.
+template <class TWeight = unsigned int>
+class TDinic
+{
+public:
+    typedef TGraph<TWeight> Graph;
+    typedef typename Graph::Capacity Capacity;
+    typedef typename Graph::Edge Edge;
+
+    unsigned int
+        phases,         // level graphs built by the last solve()
+        augmentations;  // paths pushed by the last solve()
+
+    TDinic(Graph &_graph) :
+        phases(0),
+        augmentations(0),
+        graph(_graph)
+    {};
+
+    Capacity solve(std::string s, std::string t)
+    {
+        return solve(graph.findVertex(s), graph.findVertex(t));
+    }
+
+    Capacity solve(int s, int t)
+    {
+        Capacity flow = 0;
+        phases = 0;
+        augmentations = 0;
+
+        int n = graph.countVertex();
+        if (s < 0 || s >= n || t < 0 || t >= n || s == t)
+            return flow;
+
+        if (!graph.frozen)
+            graph.freeze();
+
+        level.resize(n);
+        current.resize(n);
+
+        while (buildLevels(s, t))
+        {
+            phases++;
+            flow += blockingFlow(s, t);
+        }
+
+        return flow;
+    }
+
+private:
+    Graph
+        &graph;
+    std::vector < int >
+        level,      // distance from the source in the residual graph, -1 if unreached
+        current,    // next adjacency slot to try on each vertex
+        queue,
+        path;       // edges from the source to the vertex being explored
+
+    bool buildLevels(int s, int t)
+    {
+        std::fill(level.begin(), level.end(), -1);
+
+        queue.clear();
+        queue.push_back(s);
+        level[s] = 0;
+
+        for (unsigned int head = 0; head < queue.size(); head++)
+        {
+            int v = queue[head];
+            for (int k = graph.adj_start[v]; k < graph.adj_start[v + 1]; k++)
+            {
+                Edge &e = graph.edges[graph.adj[k]];
+                if (e.weight > 0 && level[e.to] < 0)
+                {
+                    level[e.to] = level[v] + 1;
+                    queue.push_back(e.to);
+                }
+            }
+        }
+
+        return level[t] >= 0;
+    }
+
+    Capacity blockingFlow(int s, int t)
+    {
+        std::vector < Edge > &edges = graph.edges;
+        Capacity flow = 0;
+
+        for (unsigned int v = 0; v < current.size(); v++)
+            current[v] = graph.adj_start[v];
+
+        path.clear();
+        int v = s;
+        for (;;)
+        {
+            if (v == t)
+            {
+                // push the bottleneck and go back to the tail of the first
+                // saturated edge
+                TWeight c = edges[path[0]].weight;
+                for (unsigned int i = 1; i < path.size(); i++)
+                {
+                    if (edges[path[i]].weight < c)
+                        c = edges[path[i]].weight;
+                }
+
+                unsigned int cut = path.size();
+                for (unsigned int i = 0; i < path.size(); i++)
+                {
+                    edges[path[i]].weight -= c;
+                    edges[Graph::reverse(path[i])].weight += c;
+                    if (cut == path.size() && !(edges[path[i]].weight > 0))
+                        cut = i;
+                }
+
+                flow += c;
+                augmentations++;
+
+                v = edges[path[cut]].from;
+                path.resize(cut);
+                continue;
+            }
+
+            // advance along the current arc
+            int end = graph.adj_start[v + 1];
+            for (; current[v] < end; current[v]++)
+            {
+                Edge &e = edges[graph.adj[current[v]]];
+                if (e.weight > 0 && level[e.to] == level[v] + 1)
+                    break;
+            }
+
+            if (current[v] < end)
+            {
+                int e = graph.adj[current[v]];
+                path.push_back(e);
+                v = edges[e].to;
+                continue;
+            }
+
+            // dead end: remove {v} from the level graph and retreat
+            level[v] = -1;
+            if (v == s)
+                break;
+
+            int e = path.back();
+            path.pop_back();
+            v = edges[e].from;
+            current[v]++;
+        }
+
+        return flow;
+    }
+};
+
+typedef TDinic<unsigned int> Dinic;
+
+#endif
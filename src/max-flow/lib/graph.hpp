@@ -12,9 +12,11 @@
 #include <limits>
 #include <iostream>
 #include <sstream>
+#include <stdint.h>
 
 #include "../../common/io.h"
 #include "../../common/string.h"
+#include "../../common/snapshot.h"
 
 using namespace tools;
 
@@ -29,6 +31,13 @@ public:
     typedef std::pair<int, int> Pair;
     typedef TWeight Capacity;
 
+    // How findPath looks for an augmenting path
+    enum Search
+    {
+        DEPTH_FIRST,    // recursive search, returns any path
+        BREADTH_FIRST   // shortest path (Edmonds-Karp), O(VE^2) augmentations in total
+    };
+
     class Vertex
     {
     public:
@@ -90,38 +99,14 @@ public:
     };
 
 private:
-
-    template <typename INDEX, typename TYPE>
-    class HashVector :
-        public std::tr1::unordered_map < INDEX, std::vector<TYPE> >
-    {
-    public:
-        typedef std::tr1::unordered_map < INDEX, std::vector<TYPE> > Base;
-
-        void append(INDEX key, TYPE val)
-        {
-            typename HashVector::iterator i = this->find(key);
-            if (i == this->end())
-            {
-                std::vector<TYPE> vec;
-                vec.push_back(val);
-                this->insert(typename Base::value_type(key, vec));
-            }
-            else
-            {
-                std::vector<TYPE> &vec = i->second;
-                vec.push_back(val);
-            }
-        }
-    };
+    // The max-flow engines work directly on the residual edges and the
+    // frozen adjacency below.
+    template <class W> friend class TDinic;
+    template <class W> friend class TPushRelabel;
 
     typedef std::tr1::unordered_map < std::string, int > VIndex;
-    typedef std::tr1::unordered_map < std::string, int > EIndex;
-
-    typedef HashVector< int, int > ConnectionIndex;
+    typedef std::tr1::unordered_map < uint64_t, int > EIndex; // (from, to) -> edge
 
-    ConnectionIndex
-        c_index;
     VIndex
         index;
     EIndex
@@ -133,6 +118,31 @@ private:
     TWeight
         flow;
 
+    // Compressed sparse row adjacency, built by freeze(): the ids of the
+    // edges leaving vertex v are adj[adj_start[v] .. adj_start[v + 1]), in
+    // insertion order. Edges are added in pairs, so the reverse of edge e is
+    // always e ^ 1.
+    std::vector < int >
+        adj_start,
+        adj;
+    bool
+        frozen;
+
+    // Breadth-first search state, kept between searches so that finding a
+    // path allocates nothing. A vertex is visited when mark[v] == stamp.
+    std::vector < unsigned int >
+        mark;
+    std::vector < int >
+        parent,     // edge used to reach each vertex
+        queue;
+    unsigned int
+        stamp;
+
+    static uint64_t key(int from, int to)
+    {
+        return ((uint64_t)(uint32_t)from << 32) | (uint32_t)to;
+    }
+
 public:
     std::string p2s(Pair p)
     {
@@ -141,48 +151,67 @@ public:
         return s.str();
     }
 
-    TGraph(std::string filename)
+    // Empty graph, to be built with addVertex / addEdge
+    TGraph() :
+        frozen(false),
+        stamp(0)
+    {};
+
+    TGraph(std::string filename) :
+        frozen(false),
+        stamp(0)
     {
         std::cout << "Reading [" << filename << "]" << std::endl;
 
         Reader reader(filename);
+        StringView source(reader.file.data(), reader.file.size());
 
-        std::string line;
+        if (reader.file.is_open() && loadSnapshot(snapshotName(filename), source))
+        {
+            std::cout << "Loaded snapshot [" << snapshotName(filename) << "]" << std::endl;
+            freeze();
+            return;
+        }
+
+        StringView line;
         std::size_t line_id;
         while (reader.getLine(line, line_id))
         {
-            std::vector<std::string> tokens = tools::split(line, ",");
-            if (tokens.size() != 2)
+            StringView tokens[2];
+            if (tools::split(line, ",", tokens, 2) != 2)
             {
                 std::cout << "ERROR reading line (bad format): " << line_id << std::endl;
                 continue;
             }
 
             int weight = 0;
-            try
-            {
-                std::istringstream(tokens[1]) >> weight;
-            }
-            catch (...)
+            if (!tools::parse(tokens[1], weight))
             {
                 std::cout << "ERROR reading in line (bad format of weight): " << line_id << std::endl;
                 continue;
             }
 
-            tokens = tools::split(tokens[0], "->");
-
-            if (tokens.size() != 2)
+            StringView names[2];
+            if (tools::split(tokens[0], "->", names, 2) != 2)
             {
                 std::cout << "ERROR reading line (you need to include 2 vetices): " << line_id << std::endl;
                 continue;
             }
 
+            std::string
+                from_name = names[0].str(),
+                to_name = names[1].str();
             int
-                from = addVertex(tokens[0]),
-                to = addVertex(tokens[1]);
+                from = addVertex(from_name),
+                to = addVertex(to_name);
 
-            addEdge(from, tokens[0], to, tokens[1], weight);
+            addEdge(from, from_name, to, to_name, weight);
         }
+
+        if (reader.file.is_open())
+            saveSnapshot(snapshotName(filename), source);
+
+        freeze();
     };
 
     ~TGraph()
@@ -230,9 +259,12 @@ public:
         return vertices.size();
     }
 
+    // Lookups by vertex pair and by name hash the key; they are meant for
+    // building the graph and for debugging. The algorithms below walk the
+    // frozen adjacency and use e ^ 1 for the reverse edge instead.
     int findEdge(Pair id)
     {
-    	EIndex::iterator i = edg_index.find(p2s(id));
+        EIndex::iterator i = edg_index.find(key(id.first, id.second));
         if (i != edg_index.end())
             return i->second;
         else
@@ -283,6 +315,39 @@ public:
         return edges.size();
     }
 
+    // Id of an edge of this graph (e.g. from a Path)
+    int edgeId(const Edge *e)
+    {
+        return (int)(e - &edges[0]);
+    }
+
+    // The paired edge in the opposite direction
+    static int reverse(int e)
+    {
+        return e ^ 1;
+    }
+
+    // Builds the CSR adjacency from the edge list. It is called after the
+    // graph is read; adding an edge later thaws the graph and the next
+    // search freezes it again.
+    void freeze()
+    {
+        int n = (int)vertices.size();
+
+        adj_start.assign(n + 1, 0);
+        for (unsigned int e = 0; e < edges.size(); e++)
+            adj_start[edges[e].from + 1]++;
+        for (int v = 0; v < n; v++)
+            adj_start[v + 1] += adj_start[v];
+
+        adj.resize(edges.size());
+        std::vector < int > pos(adj_start.begin(), adj_start.end() - 1);
+        for (unsigned int e = 0; e < edges.size(); e++)
+            adj[pos[edges[e].from]++] = (int)e;
+
+        frozen = true;
+    }
+
     void addEdge(int i, std::string i_name, int j, std::string j_name, TWeight w)
     {
         if (!(i >= 0 && i < (int)vertices.size())) return;
@@ -307,9 +372,7 @@ public:
 
                 id = (int)edges.size() - 1;
 
-                edg_index.insert(EIndex::value_type(p2s(Pair(i, j)), id));
-
-                c_index.append(edge.from, edge.to);
+                edg_index.insert(EIndex::value_type(key(i, j), id));
             }
 
             {
@@ -326,90 +389,221 @@ public:
 
                 id = (int)edges.size() - 1;
 
-                edg_index.insert(EIndex::value_type(p2s(Pair(j, i)), id));
-                c_index.append(edge.from, edge.to);
+                edg_index.insert(EIndex::value_type(key(j, i), id));
             }
+
+            frozen = false;
         }
     };
 
 private:
-    bool findPath_recursive(
-        int from,
-        int to,
-        std::stack < int > &s,
-        std::tr1::unordered_map < int, bool > &seen)
+    static const uint32_t SNAPSHOT_KIND = 0x48505247; // "GRPH"
+
+    // payload: sizeof(TWeight), vertex names, then every edge (forward and
+    // backward) as type, from, to, weight in insertion order
+    void saveSnapshot(std::string filename, StringView source)
     {
-        typename ConnectionIndex::iterator i = c_index.find(from);
-        if (i == c_index.end())
+        SnapshotWriter snap(SNAPSHOT_KIND);
+
+        snap.put((uint32_t)sizeof(TWeight));
+
+        snap.put((uint64_t)vertices.size());
+        for (unsigned int i = 0; i < vertices.size(); i++)
+            snap.put(vertices[i].name);
+
+        snap.put((uint64_t)edges.size());
+        for (unsigned int i = 0; i < edges.size(); i++)
         {
+            Edge &e = edges[i];
+            snap.put((uint8_t)e.type);
+            snap.put((int32_t)e.from);
+            snap.put((int32_t)e.to);
+            snap.put(e.weight);
+        }
+
+        snap.save(filename, source);
+    }
+
+    bool loadSnapshot(std::string filename, StringView source)
+    {
+        SnapshotReader snap(filename, SNAPSHOT_KIND, source);
+        if (!snap.is_valid())
+            return false;
+
+        uint32_t weight_size = 0;
+        snap.get(weight_size);
+        if (weight_size != sizeof(TWeight))
             return false;
+
+        uint64_t count = 0;
+        snap.get(count);
+        for (uint64_t i = 0; i < count && snap.is_valid(); i++)
+        {
+            std::string name;
+            snap.get(name);
+            addVertex(name);
+        }
+
+        snap.get(count);
+        for (uint64_t i = 0; i < count && snap.is_valid(); i++)
+        {
+            uint8_t type = 0;
+            int32_t from = 0, to = 0;
+            Edge edge;
+
+            snap.get(type);
+            snap.get(from);
+            snap.get(to);
+            snap.get(edge.weight);
+
+            if (from < 0 || from >= (int)vertices.size() || to < 0 || to >= (int)vertices.size())
+                break;
+
+            edge.type = type == Edge::FORWARD ? Edge::FORWARD : Edge::BACKWARD;
+            edge.from = from;
+            edge.to = to;
+            edge.from_name = vertices[from].name;
+            edge.to_name = vertices[to].name;
+            edges.push_back(edge);
+
+            edg_index.insert(EIndex::value_type(key(from, to), (int)edges.size() - 1));
         }
 
-        std::tr1::unordered_map < int, bool >::iterator k = seen.find(from);
-        if (k != seen.end())
+        if (!snap.done() || edges.size() != count)
         {
+            index.clear();
+            edg_index.clear();
+            vertices.clear();
+            edges.clear();
             return false;
         }
-        seen.insert(std::tr1::unordered_map < int, bool >::value_type(from, true));
+        return true;
+    }
 
-        std::vector<int> &nodes = i->second;
+    // {s} collects the ids of the edges on the path, last edge first
+    bool findPath_recursive(
+        int from,
+        int to,
+        std::stack < int > &s,
+        std::vector < char > &seen)
+    {
+        if (seen[from])
+        {
+            return false;
+        }
+        seen[from] = 1;
 
-        for(unsigned int j = 0; j < nodes.size(); j++)
+        for (int k = adj_start[from]; k < adj_start[from + 1]; k++)
         {
-            Edge *edg = getEdge(from, nodes[j]);
-            if (!edg || !(edg->weight > 0))
+            int e = adj[k];
+            Edge &edg = edges[e];
+            if (!(edg.weight > 0))
                 continue;
 
-            if (nodes[j] == to)
+            if (edg.to == to)
             {
-                s.push(to);
+                s.push(e);
                 return true;
             }
             else
             {
-                if (findPath_recursive(nodes[j], to, s, seen))
+                if (findPath_recursive(edg.to, to, s, seen))
                 {
-                    s.push(nodes[j]);
+                    s.push(e);
                     return true;
                 }
             }
         }
 
-        k = seen.find(from);
-        seen.erase(k);
+        seen[from] = 0;
+
+        return false;
+    }
+
+    bool findPath_breadth(
+        int from,
+        int to,
+        std::stack < int > &s)
+    {
+        if (mark.size() != vertices.size())
+        {
+            mark.assign(vertices.size(), 0);
+            parent.assign(vertices.size(), -1);
+            stamp = 0;
+        }
+        if (++stamp == 0)
+        {
+            std::fill(mark.begin(), mark.end(), 0);
+            stamp = 1;
+        }
+
+        queue.clear();
+        queue.push_back(from);
+        mark[from] = stamp;
+
+        for (unsigned int head = 0; head < queue.size(); head++)
+        {
+            int v = queue[head];
+            for (int k = adj_start[v]; k < adj_start[v + 1]; k++)
+            {
+                int e = adj[k];
+                Edge &edg = edges[e];
+                if (!(edg.weight > 0) || mark[edg.to] == stamp)
+                    continue;
+
+                mark[edg.to] = stamp;
+                parent[edg.to] = e;
+
+                if (edg.to == to)
+                {
+                    for (int u = to; u != from; u = edges[parent[u]].from)
+                        s.push(parent[u]);
+                    return true;
+                }
+                queue.push_back(edg.to);
+            }
+        }
 
         return false;
     }
 
 public:
-    Path findPath(int from, int to)
+    Path findPath(int from, int to, Search search = BREADTH_FIRST)
     {
-        std::tr1::unordered_map < int, bool >
-            seen;
+        Path p;
+
+        if (from < 0 || from >= (int)vertices.size() || to < 0 || to >= (int)vertices.size())
+            return p;
+
+        if (!frozen)
+            freeze();
+
         std::stack < int >
             stack;
 
-        findPath_recursive(from, to, stack, seen);
-
-        Path p;
+        if (search == BREADTH_FIRST)
+        {
+            findPath_breadth(from, to, stack);
+        }
+        else
+        {
+            std::vector < char >
+                seen(vertices.size(), 0);
+            findPath_recursive(from, to, stack, seen);
+        }
 
-        int _from = from;
         while (stack.size() > 0)
         {
-            int _to = stack.top();
+            p.push_back(&edges[stack.top()]);
             stack.pop();
-
-            Edge *edg = getEdge(_from, _to);
-            p.push_back(edg);
-            _from = _to;
         }
 
         return p;
     }
 
-    Path findPath(std::string f, std::string t)
+    Path findPath(std::string f, std::string t, Search search = BREADTH_FIRST)
     {
-        return findPath(findVertex(f), findVertex(t));
+        return findPath(findVertex(f), findVertex(t), search);
     }
 
     void augment(Path &p, TWeight w)
@@ -417,11 +611,7 @@ public:
         for (typename Path::iterator e = p.begin(); e != p.end(); e++)
         {
             (*e)->weight -= w;
-            Edge *edg = getEdge((*e)->to, (*e)->from);
-            if (edg)
-            {
-                edg->weight += w;
-            }
+            edges[reverse(edgeId(*e))].weight += w;
         }
     }
 
@@ -433,12 +623,12 @@ public:
             if (e.type != Edge::FORWARD)
                 continue;
 
-            Edge *rev = getEdge(e.to, e.from);
+            Edge &rev = edges[reverse(i)];
 
             std::cout
                 << "(" << e.from_name << ")"
                 << " -> (" << e.to_name << ") : "
-                << e.weight << " / " << rev->weight
+                << e.weight << " / " << rev.weight
                 << "\n";
         }
     }
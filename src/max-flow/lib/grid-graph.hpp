@@ -0,0 +1,163 @@
+#ifndef GRID_GRAPH_H
+#define GRID_GRAPH_H
+
+#include <vector>
+#include <algorithm>
+
+// A 2D or 3D grid of vertices (pixels / voxels) with implicit edges, as
+// used for segmentation cuts.
+//
+// Vertex (x, y, z) has id x + width * (y + height * z) and its neighbours
+// are computed from the coordinates, so nothing but capacities is stored:
+// one dense array per direction for the edges, plus the two terminal
+// links (to the source and to the sink) of every vertex.
+//
+// Directions come in pairs, so the opposite of direction d is d ^ 1.
+// Edges that would leave the grid do not exist; their capacities stay 0.
+template <class TWeight = unsigned int>
+class TGridGraph
+{
+public:
+    typedef TWeight Capacity;
+
+    enum Connectivity
+    {
+        CONNECT_4 = 4,      // 2D, left/right/up/down
+        CONNECT_8 = 8,      // 2D, with diagonals
+        CONNECT_6 = 6,      // 3D, faces
+        CONNECT_26 = 26     // 3D, faces, edges and corners
+    };
+
+    TGridGraph(int _width, int _height, int _depth = 1, Connectivity connectivity = CONNECT_4) :
+        pushed(0),
+        w(_width > 0 ? _width : 0),
+        h(_height > 0 ? _height : 0),
+        d(_depth > 0 ? _depth : 0),
+        n(w * h * d)
+    {
+        // the positive half of every direction, faces first
+        for (int norm = 1; norm <= 3; norm++)
+        {
+            for (int z = -1; z <= 1; z++)
+            for (int y = -1; y <= 1; y++)
+            for (int x = -1; x <= 1; x++)
+            {
+                bool positive = z > 0 || (z == 0 && (y > 0 || (y == 0 && x > 0)));
+                if (!positive || abs(x) + abs(y) + abs(z) != norm)
+                    continue;
+                if (z != 0 && (connectivity == CONNECT_4 || connectivity == CONNECT_8))
+                    continue;
+                if (norm > 1 && (connectivity == CONNECT_4 || connectivity == CONNECT_6))
+                    continue;
+
+                addDirection(x, y, z);
+                addDirection(-x, -y, -z);
+            }
+        }
+
+        cap.assign((std::size_t)n * countDirections(), 0);
+        source_cap.assign(n, 0);
+        sink_cap.assign(n, 0);
+    };
+
+    int width() const { return w; }
+    int height() const { return h; }
+    int depth() const { return d; }
+    int countVertex() const { return n; }
+    int countDirections() const { return (int)offset.size(); }
+
+    int vertex(int x, int y, int z = 0) const
+    {
+        return x + w * (y + h * z);
+    }
+
+    static int opposite(int dir)
+    {
+        return dir ^ 1;
+    }
+
+    // Id of the neighbour of {v} in direction {dir}, -1 outside the grid
+    int neighbour(int v, int dir) const
+    {
+        int
+            x = v % w + dx[dir],
+            y = v / w % h + dy[dir],
+            z = v / w / h + dz[dir];
+
+        if (x < 0 || x >= w || y < 0 || y >= h || z < 0 || z >= d)
+            return -1;
+        return v + offset[dir];
+    }
+
+    // Sets the capacity from {v} to its neighbour in direction {dir} and
+    // back. Returns false if there is no such neighbour.
+    bool setEdge(int v, int dir, TWeight forward, TWeight backward)
+    {
+        int u = neighbour(v, dir);
+        if (u < 0)
+            return false;
+
+        capacity(v, dir) = forward;
+        capacity(u, opposite(dir)) = backward;
+        return true;
+    }
+
+    // Sets the links of {v} to the source and to the sink. The part both
+    // links have in common is flow that can be pushed straight through
+    // {v}, so it is added to the flow right away and only the difference
+    // is kept. Set the terminals of each vertex once.
+    void setTerminals(int v, TWeight source, TWeight sink)
+    {
+        TWeight common = source < sink ? source : sink;
+
+        pushed += common;
+        source_cap[v] = source - common;
+        sink_cap[v] = sink - common;
+    }
+
+    // Residual capacities
+    TWeight& capacity(int v, int dir) { return cap[(std::size_t)dir * n + v]; }
+    TWeight& sourceCapacity(int v) { return source_cap[v]; }
+    TWeight& sinkCapacity(int v) { return sink_cap[v]; }
+
+    // Flow pushed so far, straight through the terminal links by
+    // setTerminals() and along the grid by the solvers
+    Capacity flow() const { return pushed; }
+
+private:
+    template <class W> friend class TBoykovKolmogorov;
+
+    Capacity
+        pushed;
+    int
+        w,
+        h,
+        d,
+        n;
+    std::vector < int >
+        dx,
+        dy,
+        dz,
+        offset;     // id difference to the neighbour in each direction
+    std::vector < TWeight >
+        cap,        // cap[dir * n + v]: residual capacity of v -> neighbour(v, dir)
+        source_cap, // residual capacity of s -> v
+        sink_cap;   // residual capacity of v -> t
+
+    static int abs(int a)
+    {
+        return a < 0 ? -a : a;
+    }
+
+    void addDirection(int x, int y, int z)
+    {
+        dx.push_back(x);
+        dy.push_back(y);
+        dz.push_back(z);
+        offset.push_back(x + w * (y + h * z));
+    }
+};
+
+typedef TGridGraph<unsigned int> GridGraph;
+
+#endif
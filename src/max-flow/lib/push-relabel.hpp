@@ -0,0 +1,367 @@
+#ifndef PUSH_RELABEL_H
+#define PUSH_RELABEL_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <algorithm>
+
+#include "graph.hpp"
+
+// Preflow-push (push-relabel) max-flow on the residual edges of a TGraph.
+//
+// Phase 1 computes a maximum preflow: active vertices (with excess and a
+// height below n) push excess downhill along admissible edges and are
+// relabelled when they have none left. The active vertex is picked either
+// in FIFO order or highest label first. Two heuristics keep the heights
+// tight:
+//  - global relabel: every ~n relabels the heights are reset to the exact
+//    residual distance to the sink with a reverse breadth-first search;
+//  - gap: when no vertex is left at some height g, every vertex above g
+//    can no longer reach the sink and is lifted to n at once.
+//
+// Phase 2 returns the excess stranded on vertices that cannot reach the
+// sink back to the source, so the edges end up holding a proper flow and
+// TGraph::print() shows the final state as with the other engines.
+template <class TWeight = unsigned int>
+class TPushRelabel
+{
+public:
+    typedef TGraph<TWeight> Graph;
+    typedef typename Graph::Capacity Capacity;
+    typedef typename Graph::Edge Edge;
+
+    enum Selection
+    {
+        FIFO,
+        HIGHEST_LABEL
+    };
+
+    Selection
+        selection;
+    unsigned int
+        pushes,             // statistics of the last solve()
+        relabels,
+        global_relabels,
+        gaps;
+
+    TPushRelabel(Graph &_graph, Selection _selection = HIGHEST_LABEL) :
+        selection(_selection),
+        pushes(0),
+        relabels(0),
+        global_relabels(0),
+        gaps(0),
+        graph(_graph)
+    {};
+
+    Capacity solve(std::string s, std::string t)
+    {
+        return solve(graph.findVertex(s), graph.findVertex(t));
+    }
+
+    Capacity solve(int s, int t)
+    {
+        pushes = relabels = global_relabels = gaps = 0;
+
+        n = graph.countVertex();
+        if (s < 0 || s >= n || t < 0 || t >= n || s == t)
+            return 0;
+
+        if (!graph.frozen)
+            graph.freeze();
+
+        source = s;
+        sink = t;
+        returning = false;
+        limit = n;
+
+        height.assign(n, 0);
+        excess.assign(n, 0);
+        active.assign(n, 0);
+        current.resize(n);
+        count.assign(n + 1, 0);
+        buckets.assign(n, std::vector < int >());
+
+        // saturate every edge leaving the source
+        std::vector < Edge > &edges = graph.edges;
+        for (int k = graph.adj_start[s]; k < graph.adj_start[s + 1]; k++)
+        {
+            int e = graph.adj[k];
+            TWeight w = edges[e].weight;
+            if (!(w > 0))
+                continue;
+
+            edges[e].weight -= w;
+            edges[Graph::reverse(e)].weight += w;
+            excess[edges[e].to] += w;
+            pushes++;
+        }
+
+        globalRelabel();
+
+        for (int v = nextActive(); v >= 0; v = nextActive())
+        {
+            discharge(v);
+
+            if (since_global > (unsigned int)n)
+                globalRelabel();
+        }
+
+        Capacity flow = excess[sink];
+
+        returnExcess();
+
+        return flow;
+    }
+
+private:
+    Graph
+        &graph;
+    int
+        n,
+        source,
+        sink,
+        limit,      // vertices at this height are not active
+        top;        // highest bucket that may be non empty
+    bool
+        returning;  // phase 2
+    unsigned int
+        since_global;
+    std::vector < int >
+        height,
+        current,    // next adjacency slot to try on each vertex
+        count,      // vertices at each height below n (phase 1)
+        bfs;
+    std::vector < Capacity >
+        excess;
+    std::vector < char >
+        active;
+    std::vector < std::vector < int > >
+        buckets;    // active vertices by height (highest label selection)
+    std::deque < int >
+        fifo;
+
+    bool useBuckets()
+    {
+        return selection == HIGHEST_LABEL && !returning;
+    }
+
+    void activate(int v)
+    {
+        if (active[v] || v == source || v == sink || !(excess[v] > 0) || height[v] >= limit)
+            return;
+
+        active[v] = 1;
+        if (useBuckets())
+        {
+            buckets[height[v]].push_back(v);
+            if (height[v] > top)
+                top = height[v];
+        }
+        else
+        {
+            fifo.push_back(v);
+        }
+    }
+
+    int nextActive()
+    {
+        for (;;)
+        {
+            int v = -1;
+            if (useBuckets())
+            {
+                while (top >= 0 && buckets[top].empty())
+                    top--;
+                if (top < 0)
+                    return -1;
+
+                v = buckets[top].back();
+                buckets[top].pop_back();
+            }
+            else
+            {
+                if (fifo.empty())
+                    return -1;
+
+                v = fifo.front();
+                fifo.pop_front();
+            }
+
+            // entries can go stale when a gap lifts a queued vertex
+            bool valid = active[v] && height[v] < limit;
+            active[v] = 0;
+            if (valid)
+                return v;
+        }
+    }
+
+    void clearActive()
+    {
+        for (unsigned int h = 0; h < buckets.size(); h++)
+            buckets[h].clear();
+        fifo.clear();
+        std::fill(active.begin(), active.end(), 0);
+        top = -1;
+    }
+
+    void discharge(int v)
+    {
+        std::vector < Edge > &edges = graph.edges;
+
+        while (excess[v] > 0)
+        {
+            if (current[v] == graph.adj_start[v + 1])
+            {
+                relabel(v);
+                if (height[v] >= limit)
+                    break;
+                continue;
+            }
+
+            int e = graph.adj[current[v]];
+            Edge &edg = edges[e];
+            if (edg.weight > 0 && height[v] == height[edg.to] + 1)
+            {
+                TWeight d = excess[v] < edg.weight ? (TWeight)excess[v] : edg.weight;
+                edg.weight -= d;
+                edges[Graph::reverse(e)].weight += d;
+                excess[v] -= d;
+                excess[edg.to] += d;
+                pushes++;
+
+                activate(edg.to);
+            }
+            else
+            {
+                current[v]++;
+            }
+        }
+    }
+
+    void relabel(int v)
+    {
+        std::vector < Edge > &edges = graph.edges;
+
+        int h = 2 * n;
+        for (int k = graph.adj_start[v]; k < graph.adj_start[v + 1]; k++)
+        {
+            Edge &edg = edges[graph.adj[k]];
+            if (edg.weight > 0 && height[edg.to] < h)
+                h = height[edg.to];
+        }
+        h++;
+
+        relabels++;
+        since_global++;
+        current[v] = graph.adj_start[v];
+
+        if (returning)
+        {
+            height[v] = h;
+            return;
+        }
+
+        int old = height[v];
+        if (old < n)
+            count[old]--;
+
+        if (old < n && count[old] == 0)
+        {
+            height[v] = n;
+            gap(old);
+            return;
+        }
+
+        height[v] = h < n ? h : n;
+        if (height[v] < n)
+            count[height[v]]++;
+    }
+
+    // nothing is left at height {g}: everything above it is cut off the sink
+    void gap(int g)
+    {
+        gaps++;
+        for (int u = 0; u < n; u++)
+        {
+            if (u == source || height[u] <= g || height[u] >= n)
+                continue;
+
+            count[height[u]]--;
+            height[u] = n;
+            current[u] = graph.adj_start[u];
+        }
+    }
+
+    // Sets the heights to the exact residual distances to {target}
+    // (vertices that cannot reach it get {unreached}) and rebuilds the
+    // active set. The source and the sink are never relabelled here.
+    void distances(int target, int unreached)
+    {
+        std::vector < Edge > &edges = graph.edges;
+
+        std::fill(height.begin(), height.end(), unreached);
+        height[target] = 0;
+
+        bfs.clear();
+        bfs.push_back(target);
+        for (unsigned int head = 0; head < bfs.size(); head++)
+        {
+            int v = bfs[head];
+            for (int k = graph.adj_start[v]; k < graph.adj_start[v + 1]; k++)
+            {
+                int e = graph.adj[k];
+                int u = edges[e].to;
+
+                // residual edge u -> v is the reverse of v -> u
+                if (height[u] != unreached || u == source || u == sink || !(edges[Graph::reverse(e)].weight > 0))
+                    continue;
+
+                height[u] = height[v] + 1;
+                bfs.push_back(u);
+            }
+        }
+
+        for (int v = 0; v < n; v++)
+            current[v] = graph.adj_start[v];
+
+        clearActive();
+        for (int v = 0; v < n; v++)
+            activate(v);
+
+        since_global = 0;
+    }
+
+    void globalRelabel()
+    {
+        global_relabels++;
+
+        distances(sink, n);
+        height[source] = n;
+
+        std::fill(count.begin(), count.end(), 0);
+        for (int v = 0; v < n; v++)
+        {
+            if (height[v] < n)
+                count[height[v]]++;
+        }
+    }
+
+    // Phase 2: send the excess left on vertices cut off from the sink back
+    // to the source. Heights become distances to the source; the sink is
+    // never admissible.
+    void returnExcess()
+    {
+        returning = true;
+        limit = 2 * n + 1;
+
+        distances(source, 2 * n);
+
+        for (int v = nextActive(); v >= 0; v = nextActive())
+            discharge(v);
+    }
+};
+
+typedef TPushRelabel<unsigned int> PushRelabel;
+
+#endif
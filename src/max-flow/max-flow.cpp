@@ -1,5 +1,6 @@
 #include <iostream>
 #include "lib/graph.hpp"
+#include "lib/dinic.hpp"
 #include "../common/io.h"
 
 using namespace std;
@@ -33,6 +34,8 @@ int main(int argc, char *argv[])
     // Example algorithm:
     // ** Find a path from {s} to {t} ** [hint: Graph::Path p = graph.findPath("s", "t");]
     //                                   [     You can print the path with: p.print();]
+    //                                   [     Shortest paths are used by default, pass]
+    //                                   [     Graph::DEPTH_FIRST as 3rd argument for DFS]
     // repeat...
     //     ** Find the capacity for the path found ** [hint: Graph::Capacity c = p.findMaxCapacity()]
     //     ** Add current capacity to the total flow ** [hint: flow += c]
@@ -41,6 +44,9 @@ int main(int argc, char *argv[])
     // ... until we can't find a valid path [hint: p.isValid() == true]
     // end
 
+    // To check your result, the same flow can be computed with Dinic's algorithm:
+    // [hint: Dinic dinic(graph); Graph::Capacity f = dinic.solve("s", "t");]
+
     cout << "\nThe flow for this graph is: " << flow << "\n\n\n";
     tools::wait();
 }
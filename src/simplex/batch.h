@@ -0,0 +1,609 @@
+#ifndef SIMPLEX_BATCH_H
+#define SIMPLEX_BATCH_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <math.h>
+#include <algorithm>
+#include <utility>
+#include "simplex-tools.h"
+
+namespace simplex
+{
+    // Many problems of the same shape (variables and constraints), solved
+    // together with one vector lane per problem.
+    //
+    // The problems are kept in blocks of BLOCK lanes, and the tableaux of a
+    // block as structure of arrays: T[I * W + J][lane] is TS[I][J] of one
+    // problem, so the elements of all the problems at the same place are
+    // contiguous: the pivot update is a kernel::updateLanes() over every
+    // (I, J), with one factor and pivot row entry per lane, and the pricing
+    // and ratio test are kernel::largest() and kernel::ratio() over the rows.
+    // Problems that are done (optimal or without solution) get a 0 factor
+    // and are left as they are; blocks where all of them are done are skipped.
+    //
+    // Every lane makes the pivots Problem makes with pricing::DANTZIG (and
+    // Bland's rule after pricing::DEGENERATE_LIMIT degenerate pivots), with
+    // the same arithmetic: the results are bit for bit those of solving the
+    // problems one at a time. The other pricing rules are not supported.
+    class Batch
+    {
+    public:
+        enum
+        {
+            BLOCK = 64      // lanes per block, a multiple of Tableau::PADDING
+        };
+
+        Batch() :
+            pivotKernel(kernel::BEST),
+            isOptimal(true),
+            NV(0),
+            NC(0),
+            W(0),
+            lanes(0)
+        {};
+
+        kernel::Kernel
+            pivotKernel;    // vector code used by Formula()
+
+        bool
+            isOptimal;      // every problem is done
+
+        // Added up over the problems; iterations counts the steps of each
+        // block that was not done yet
+        Problem::Counters
+            counters;
+
+        // Puts the initial tableau of {p} (built as Problem::Prepare()
+        // does; {p} itself need not be prepared) in the next lane. Returns
+        // false, leaving the batch as it was, if {p} has no objective, is
+        // not well formed, has integer variables (see branch.h), or has
+        // another shape than the problems before it.
+        bool add(const Problem &p)
+        {
+            if (p.objective == Problem::VOID || p.variables.size() < 2 || !p.isWellFormed() || !p.integers.empty())
+                return false;
+
+            unsigned int
+                nv = (unsigned int)p.variables.size() - 1,
+                nc = p.constraints.rows();
+            if (lanes == 0)
+            {
+                NV = nv;
+                NC = nc;
+                W = NV + 2;
+                factor.resize(NC + 2, BLOCK);
+                row.resize(W, BLOCK);
+                work.resize(2, BLOCK);
+            }
+            else if (nv != NV || nc != NC)
+            {
+                return false;
+            }
+
+            if (lanes % BLOCK == 0)
+            {
+                blocks.push_back(Block((NC + 2) * W, NC + 2));
+
+                // -A: the zeros left out of the sparse rows become -0.0, as
+                // in Problem::Prepare()
+                for (unsigned int I = 2; I <= NC + 1; I++)
+                {
+                    for (unsigned int J = 2; J <= NV + 1; J++)
+                        std::fill(at(blocks.back(), I, J), at(blocks.back(), I, J) + BLOCK, -0.0);
+                }
+            }
+
+            Block &B = blocks.back();
+            unsigned int l = B.lanes;
+            B.problem[l] = lanes;
+            slot.push_back(lanes);
+            double sign = p.objective;
+
+            for (unsigned int J = 1; J <= NV; J++)
+                at(B, 1, J + 1)[l] = p.variables[J - 1] * sign;
+            at(B, 1, 1)[l] = p.variables[NV] * sign;
+
+            const SparseMatrix &A = p.constraints;
+            for (unsigned int I = 1; I <= NC; I++)
+            {
+                for (std::size_t e = A.start[I - 1]; e < A.start[I]; e++)
+                    at(B, I + 1, A.index[e] + 2)[l] = -A.value[e];
+                at(B, I + 1, 1)[l] = A.rhs[I - 1];
+            }
+
+            for (unsigned int J = 1; J <= NV; J++)
+                at(B, 0, J + 1)[l] = J;
+            for (unsigned int I = NV + 1; I <= NV + NC; I++)
+                at(B, I - NV + 1, 0)[l] = I;
+
+            B.optimal[l] = false;
+            B.lanes++;
+            B.active++;
+            lanes++;
+            isOptimal = false;
+            return true;
+        }
+
+        unsigned int size() const { return lanes; }
+        unsigned int NumberOfVariables() const { return NV; }
+        unsigned int NumberOfConstraints() const { return NC; }
+
+        // Problem::Pivot() in every problem that is not done yet
+        void Pivot()
+        {
+            for (std::size_t b = 0; b < blocks.size(); b++)
+            {
+                if (blocks[b].active)
+                    pivot(blocks[b]);
+            }
+        }
+
+        // Problem::Formula() in every problem that pivots
+        void Formula()
+        {
+            for (std::size_t b = 0; b < blocks.size(); b++)
+            {
+                if (blocks[b].active)
+                    formula(blocks[b]);
+            }
+        }
+
+        // Problem::Optimize() in every problem that is not done yet
+        void Optimize()
+        {
+            isOptimal = true;
+            for (std::size_t b = 0; b < blocks.size(); b++)
+            {
+                if (blocks[b].active)
+                    optimize(blocks[b]);
+                if (blocks[b].active)
+                    isOptimal = false;
+            }
+        }
+
+        // Pivot(), Formula() and Optimize() until every problem is done, one
+        // block at a time, so the tableaux being worked on stay in cache.
+        // A lane that is done takes over a problem not done yet from the
+        // last blocks, so the lanes keep busy until the blocks run out.
+        // Each problem makes the same pivots as with the three steps.
+        void Solve()
+        {
+            unsigned int last = lanes;  // the problems after it are done, or taken
+            for (unsigned int b = 0; b < blocks.size(); b++)
+            {
+                Block &B = blocks[b];
+                unsigned int end = b * BLOCK + B.lanes;
+                while (B.active)
+                {
+                    pivot(B);
+                    formula(B);
+                    optimize(B);
+
+                    unsigned int done[BLOCK], from[BLOCK], n = 0;
+                    for (unsigned int l = 0; l < B.lanes; l++)
+                    {
+                        if (!B.optimal[l])
+                            continue;
+
+                        while (last > end && blocks[(last - 1) / BLOCK].optimal[(last - 1) % BLOCK])
+                            last--;
+                        if (last == end)
+                            break;
+                        done[n] = l;
+                        from[n++] = --last;
+                    }
+                    exchange(B, done, from, n);
+                }
+            }
+            isOptimal = true;
+        }
+
+        // Problem::isOptimal of problem {i}, counting from 0 in the order
+        // they were added
+        bool isDone(unsigned int i) const { return blocks[slot[i] / BLOCK].optimal[slot[i] % BLOCK]; }
+
+        // Problem::error of problem {i}
+        bool hasFailed(unsigned int i) const { return blocks[slot[i] / BLOCK].error[slot[i] % BLOCK]; }
+
+        // the "Function" value of result()
+        double objectiveValue(unsigned int i) { return get(i, 1, 1); }
+
+        // Value of variable {var} (from 1) in problem {i}, 0 if not basic
+        double value(unsigned int i, unsigned int var)
+        {
+            for (unsigned int I = 2; I <= NC + 1; I++)
+            {
+                if (get(i, I, 0) == 1.0 * var)
+                    return get(i, I, 1);
+            }
+            return 0.0;
+        }
+
+        // Problem::result() of problem {i}
+        void result(unsigned int i)
+        {
+            if (hasFailed(i))
+            {
+                std::cout << "No solution!" << std::endl;
+                return;
+            }
+
+            for (unsigned int I = 1; I <= NV; I++)
+            {
+                for (unsigned int J = 2; J <= NC + 1; J++)
+                {
+                    if (get(i, J, 0) == 1.0 * I)
+                        std::cout
+                            << "Variable #" << I << ": "
+                            << get(i, J, 1) << std::endl;
+                }
+            }
+            std::cout
+                << "Function: "
+                << get(i, 1, 1) << std::endl;
+        }
+
+    private:
+        struct Block
+        {
+            Block(unsigned int rows, unsigned int columnRows) :
+                T(rows, BLOCK),
+                column(columnRows, BLOCK),
+                lanes(0),
+                active(0)
+            {
+                for (unsigned int l = 0; l < BLOCK; l++)
+                {
+                    problem[l] = P1[l] = P2[l] = stalled[l] = 0;
+                    error[l] = false;
+                    optimal[l] = true;  // the lanes not used are done
+                }
+            };
+
+            Tableau
+                T,          // (NC + 2) * W rows, one column per lane
+                column;     // pivot column of each lane, by pivot()
+            unsigned int
+                problem[BLOCK],     // in each lane, by the order of add()
+                P1[BLOCK],
+                P2[BLOCK],
+                stalled[BLOCK],     // degenerate pivots in a row
+                lanes,      // lanes used
+                active;     // ... of them not done yet
+            bool
+                error[BLOCK],
+                optimal[BLOCK];
+        };
+
+        std::vector<Block>
+            blocks;
+        std::vector<unsigned int>
+            slot;       // BLOCK * block + lane of each problem, by the order of add()
+        unsigned int
+            NV,
+            NC,
+            W,          // NV + 2, the columns of each tableau
+            lanes;
+        Tableau
+            factor,     // TS[I][P2] / TS[P1][P2] of each lane, 0 where row I is left as it is
+            row,        // pivot row of each lane
+            work;       // best and which, scratch of pivot() and optimize()
+
+        double* at(Block &B, unsigned int I, unsigned int J) { return B.T[I * W + J]; }
+
+        // TS[I][J] of problem {i}
+        double get(unsigned int i, unsigned int I, unsigned int J) { return at(blocks[slot[i] / BLOCK], I, J)[slot[i] % BLOCK]; }
+
+        // Between two steps, swaps the problems in lanes {a} of {A}, which
+        // are done, with those of the slots {from}, which are not. Row by row,
+        // so the slots next to each other share the cache lines.
+        void exchange(Block &A, const unsigned int *a, const unsigned int *from, unsigned int n)
+        {
+            for (unsigned int r = 0; r < (NC + 2) * W; r++)
+            {
+                double *to = A.T[r];
+                for (unsigned int i = 0; i < n; i++)
+                    std::swap(to[a[i]], blocks[from[i] / BLOCK].T[r][from[i] % BLOCK]);
+            }
+
+            for (unsigned int i = 0; i < n; i++)
+            {
+                Block &B = blocks[from[i] / BLOCK];
+                unsigned int l = a[i], b = from[i] % BLOCK;
+
+                std::swap(A.problem[l], B.problem[b]);
+                std::swap(A.stalled[l], B.stalled[b]);
+                std::swap(A.error[l], B.error[b]);
+                std::swap(A.optimal[l], B.optimal[b]);
+                std::swap(slot[A.problem[l]], slot[B.problem[b]]);
+                A.active++;
+                B.active--;
+            }
+        }
+
+        void pivot(Block &B)
+        {
+            unsigned int I, J, l;
+            double
+                *best = work[0],
+                *which = work[1];
+
+            kernel::Kernel k = pivotKernel;
+            if (k == kernel::BEST || !kernel::supported(k))
+                k = kernel::best();
+
+            counters.iterations++;
+
+            // entering column: the largest reduced cost, the first one on a tie
+            for (l = 0; l < BLOCK; l++)
+                best[l] = which[l] = 0.0;
+            for (J = 2; J <= NV + 1; J++)
+                kernel::largest(k, best, which, at(B, 1, J), J, BLOCK);
+
+            for (l = 0; l < BLOCK; l++)
+            {
+                if (B.optimal[l])
+                    B.P2[l] = 0;
+                else if (B.stalled[l] >= pricing::DEGENERATE_LIMIT)
+                    B.P2[l] = blandColumn(B, l);
+                else
+                    B.P2[l] = (unsigned int)which[l];
+            }
+
+            // the pivot column of each lane, kept for formula()
+            for (I = 1; I <= NC + 1; I++)
+            {
+                double *c = B.column[I];
+                for (l = 0; l < BLOCK; l++)
+                    c[l] = B.P2[l] ? at(B, I, B.P2[l])[l] : 0.0;
+            }
+
+            // ratio test: the first smallest |TS[I][1] / TS[I][P2]| with TS[I][P2] < 0
+            for (l = 0; l < BLOCK; l++)
+            {
+                best[l] = HUGE_VAL;
+                which[l] = 0.0;
+            }
+            for (I = 2; I <= NC + 1; I++)
+                kernel::ratio(k, best, which, at(B, I, 1), B.column[I], I, BLOCK);
+
+            for (l = 0; l < BLOCK; l++)
+            {
+                B.P1[l] = 0;
+                if (B.P2[l] == 0)
+                    continue;
+
+                bool bland = B.stalled[l] >= pricing::DEGENERATE_LIMIT;
+                B.P1[l] = bland ? blandRow(B, l) : (unsigned int)which[l];
+                if (B.P1[l] == 0)
+                {
+                    B.error[l] = true;  // unbounded
+                    continue;
+                }
+                count(B, l, bland);
+
+                double V = at(B, 0, B.P2[l])[l];
+                at(B, 0, B.P2[l])[l] = at(B, B.P1[l], 0)[l];
+                at(B, B.P1[l], 0)[l] = V;
+            }
+        }
+
+        void formula(Block &B)
+        {
+            unsigned int I, J, l;
+
+            kernel::Kernel k = pivotKernel;
+            if (k == kernel::BEST || !kernel::supported(k))
+                k = kernel::best();
+
+            // the pivot row, and the factor of each row (0: left as it is);
+            // p1 is 0 in the lanes that do not pivot
+            unsigned int p1[BLOCK];
+            double *inverse = work[0];
+            bool any = false;
+            for (l = 0; l < BLOCK; l++)
+            {
+                bool pivots = !B.error[l] && B.P1[l] >= 2 && B.P2[l] >= 2;
+                any = any || pivots;
+                p1[l] = pivots ? B.P1[l] : 0;
+                inverse[l] = pivots ? 1.0 / B.column[p1[l]][l] : 0.0;
+            }
+            if (!any)
+                return;
+
+            for (J = 1; J <= NV + 1; J++)
+            {
+                double *r = row[J];
+                for (l = 0; l < BLOCK; l++)
+                    r[l] = p1[l] ? at(B, p1[l], J)[l] : 0.0;
+            }
+            for (I = 1; I <= NC + 1; I++)
+            {
+                double *f = factor[I];
+                const double *c = B.column[I];
+                for (l = 0; l < BLOCK; l++)
+                    f[l] = p1[l] && I != p1[l] ? c[l] * inverse[l] : 0.0;
+            }
+
+            // TS[I][J] -= TS[P1][J] * TS[I][P2] / TS[P1][P2]
+            for (I = 1; I <= NC + 1; I++)
+            {
+                for (J = 1; J <= NV + 1; J++)
+                    kernel::updateLanes(k, at(B, I, J), factor[I], row[J], BLOCK);
+            }
+
+            // scale the pivot row and column as Problem::Formula() does; the
+            // kernel left the pivot row alone but updated the pivot column,
+            // which is scaled from its value before
+            for (l = 0; l < BLOCK; l++)
+            {
+                if (!p1[l])
+                    continue;
+
+                unsigned int P = p1[l], Q = B.P2[l];
+                double pivot = inverse[l];
+                at(B, P, Q)[l] = pivot;
+                for (J = 1; J <= NV + 1; J++)
+                {
+                    if (J != Q)
+                        at(B, P, J)[l] = row[J][l] * fabs(pivot);
+                }
+                for (I = 1; I <= NC + 1; I++)
+                {
+                    if (I != P)
+                        at(B, I, Q)[l] = B.column[I][l] * pivot;
+                }
+            }
+        }
+
+        void optimize(Block &B)
+        {
+            unsigned int I, J, l;
+
+            // negative[l]: how many right hand sides are negative
+            double *negative = work[0];
+            for (l = 0; l < BLOCK; l++)
+                negative[l] = 0.0;
+            for (I = 2; I <= NC + 1; I++)
+            {
+                const double *rhs = at(B, I, 1);
+                for (l = 0; l < BLOCK; l++)
+                {
+                    if (rhs[l] < 0.0)
+                        negative[l] += 1.0;
+                }
+            }
+
+            for (l = 0; l < BLOCK; l++)
+            {
+                if (B.optimal[l])
+                    continue;
+
+                if (negative[l] != 0.0)
+                    B.error[l] = true;
+
+                B.optimal[l] = true;
+                for (J = 2; J <= NV + 1 && !B.error[l]; J++)
+                {
+                    if (at(B, 1, J)[l] > 0.0)
+                    {
+                        B.optimal[l] = false;
+                        break;
+                    }
+                }
+
+                if (B.optimal[l])
+                    B.active--;
+            }
+        }
+
+        // Bland's rule: the improving column of the lowest variable
+        unsigned int blandColumn(Block &B, unsigned int l)
+        {
+            unsigned int P = 0;
+            for (unsigned int J = 2; J <= NV + 1; J++)
+            {
+                if (at(B, 1, J)[l] > 0.0 && (P == 0 || at(B, 0, J)[l] < at(B, 0, P)[l]))
+                    P = J;
+            }
+            return P;
+        }
+
+        // ... and the first smallest ratio, then the lowest variable
+        unsigned int blandRow(Block &B, unsigned int l)
+        {
+            unsigned int P = 0;
+            double RAP = HUGE_VAL;
+            for (unsigned int I = 2; I <= NC + 1; I++)
+            {
+                double c = B.column[I][l];
+                if (c >= 0.0)
+                    continue;
+
+                double V = fabs(at(B, I, 1)[l] / c);
+                if (V < RAP || (V == RAP && at(B, I, 0)[l] < at(B, P, 0)[l]))
+                {
+                    RAP = V;
+                    P = I;
+                }
+            }
+            return P;
+        }
+
+        // Problem::count() for the pivot of lane {l}
+        void count(Block &B, unsigned int l, bool bland)
+        {
+            counters.pivots++;
+            if (bland)
+                counters.bland++;
+
+            if (fabs(at(B, B.P1[l], 1)[l]) <= TOLERANCE)
+            {
+                counters.degenerate++;
+                B.stalled[l]++;
+            }
+            else
+            {
+                B.stalled[l] = 0;
+            }
+        }
+    };
+
+    // Reads a file of many problems into a Batch: each problem is written
+    // as for Parser, and starts at its own [OBJECTIVE] section. Problems
+    // with errors, or of another shape than the first one, are reported
+    // and left out. There are no snapshots.
+    class BatchParser
+    {
+    public:
+        BatchParser(std::string filename)
+        {
+            parse(filename);
+        }
+
+        void parse(std::string filename)
+        {
+            std::cout << "Reading [" << filename << "]" << std::endl;
+
+            Reader reader(filename);
+
+            Problem p;
+            Parser::Mode mode = Parser::IGNORE;
+            StringView line;
+            std::size_t line_id, first = 0;
+            unsigned int number = 0;
+            while (reader.getLine(line, line_id))
+            {
+                if (iequals(line, "[objective]") && first != 0)
+                {
+                    add(p, ++number, first);
+                    p = Problem();
+                    first = 0;
+                }
+                if (first == 0)
+                    first = line_id;
+
+                Parser::read(p, mode, line, line_id);
+            }
+            if (first != 0)
+                add(p, ++number, first);
+        }
+
+        // Hands the batch over; the parser is left empty
+        Batch getBatch() { return std::move(batch); }
+
+    private:
+        Batch
+            batch;
+
+        void add(const Problem &p, unsigned int number, std::size_t line_id)
+        {
+            if (!batch.add(p))
+                std::cerr << "BatchParser: ERROR! Problem #" << number << " (line " << line_id << ") is not well formed, has integer variables or is not of the shape of the first one: left out" << std::endl;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,491 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <cmath>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include "simplex-tools.h"
+#include "batch.h"
+#include "branch.h"
+
+using namespace simplex;
+using namespace std;
+
+// Times the pivot update kernels on random tableaux of growing size and
+// checks them against the scalar kernel (which they must match exactly)
+// and against the former per element division (which they must match
+// within the tolerance documented in kernel.h).
+//
+// Then times whole iterations of a dense size x size LP with the rows
+// split across 1, 2, 4, ... threads.
+//
+// Then solves wide LPs (few constraints, many variables) with both the
+// tableau and the revised method and compares their time and optimum.
+//
+// Then solves one of them with each pricing rule and method.
+//
+// Then solves many small LPs one Problem at a time and as one Batch, and
+// checks that they agree bit for bit.
+//
+// Then changes a solved LP (a new constraint, a smaller right hand side)
+// again and again, and solves it from the last basis by dual simplex and
+// from the start.
+//
+// Last, solves an integer problem by branch and bound on 1, 2, 4, ...
+// threads.
+//
+//   ./simplex-benchmark [max size = 2048] [max threads = hardware threads]
+
+static unsigned int lcg_state = 12345;
+
+static double next_random()
+{
+    lcg_state = lcg_state * 1103515245u + 12345u;
+    return (double)((lcg_state >> 8) % 20001) / 1000.0 - 10.0; // [-10, 10]
+}
+
+static void fill(Tableau &TS, unsigned int rows, unsigned int cols)
+{
+    lcg_state = 12345;
+    TS.resize(rows, cols);
+    for (unsigned int i = 0; i < rows; i++)
+        for (unsigned int j = 0; j < cols; j++)
+            TS[i][j] = next_random();
+}
+
+// the update as Formula() used to do it
+static void reference(Tableau &TS, unsigned int rows, unsigned int cols, unsigned int P1, unsigned int P2)
+{
+    for (unsigned int I = 1; I < rows; I++)
+    {
+        if (I == P1)
+            continue;
+        for (unsigned int J = 1; J < cols; J++)
+        {
+            if (J != P2)
+                TS[I][J] -= TS[P1][J] * TS[I][P2] / TS[P1][P2];
+        }
+    }
+}
+
+// largest |a - b| relative to the element or the subtracted term, whichever
+// is larger, in units of 2^-52
+static double difference(Tableau &a, Tableau &b, Tableau &original, unsigned int P1, unsigned int P2)
+{
+    double worst = 0;
+    for (unsigned int I = 1; I < a.rows(); I++)
+    {
+        for (unsigned int J = 1; J < a.cols(); J++)
+        {
+            double scale = fabs(original[P1][J] * original[I][P2] / original[P1][P2]);
+            if (fabs(original[I][J]) > scale)
+                scale = fabs(original[I][J]);
+
+            double d = fabs(a[I][J] - b[I][J]);
+            if (d > 0 && d / scale > worst)
+                worst = d / scale;
+        }
+    }
+    return worst / 2.220446049250313e-16;
+}
+
+// maximize sum(c x) s.t. A x <= b, with positive A, b and c, from where
+// the random sequence is; the problem is not prepared
+static void generate(Problem &p, unsigned int rows, unsigned int cols)
+{
+    p.objective = Problem::MAXIMIZE;
+
+    p.variables.resize(cols + 1);
+    for (unsigned int j = 0; j < cols; j++)
+        p.variables[j] = 11.0 + next_random();
+    p.variables[cols] = 0;
+
+    p.constraints.clear();
+    std::vector<double> row(cols + 1);
+    for (unsigned int i = 0; i < rows; i++)
+    {
+        for (unsigned int j = 0; j < cols; j++)
+            row[j] = 10.0 + next_random();
+        row[cols] = 1000.0 + 50.0 * next_random();
+        p.constraints.addDenseRow(row);
+    }
+}
+
+// The same, always the same one, prepared
+static void dense(Problem &p, unsigned int rows, unsigned int cols)
+{
+    lcg_state = 12345;
+    generate(p, rows, cols);
+    p.Prepare();
+}
+
+// Runs up to {limit} iterations, returns the wall time per iteration in ms
+static double iterate(Problem &problem, unsigned int limit, unsigned int &iterations)
+{
+    // wall time: clock() would add up the time of every thread
+    iterations = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (!problem.isOptimal && !problem.error && iterations < limit)
+    {
+        problem.Pivot();
+        problem.Formula();
+        problem.Optimize();
+        iterations++;
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (iterations ? iterations : 1);
+}
+
+static bool identical(Tableau &a, Tableau &b)
+{
+    for (unsigned int I = 0; I < a.rows(); I++)
+        for (unsigned int J = 0; J < a.cols(); J++)
+            if (a[I][J] != b[I][J])
+                return false;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned int max_size = argc > 1 ? atoi(argv[1]) : 2048;
+
+    kernel::Kernel kernels[] = { kernel::SCALAR, kernel::SSE2, kernel::AVX2, kernel::AVX512 };
+    unsigned int count = sizeof(kernels) / sizeof(kernels[0]);
+
+    cout << "best kernel on this machine: " << kernel::name(kernel::best()) << "\n\n";
+    cout << setw(12) << "tableau";
+    for (unsigned int k = 0; k < count; k++)
+        cout << setw(12) << kernel::name(kernels[k]);
+    cout << setw(12) << "ulp vs div" << "\n";
+    cout << setw(12) << "";
+    for (unsigned int k = 0; k < count; k++)
+        cout << setw(12) << "ms/pivot";
+    cout << "\n";
+
+    for (unsigned int size = 64; size <= max_size; size *= 2)
+    {
+        unsigned int rows = size, cols = size;
+        unsigned int P1 = rows / 2, P2 = cols / 3;
+
+        Tableau original, expected, scalar;
+        fill(original, rows, cols);
+        fill(expected, rows, cols);
+        reference(expected, rows, cols, P1, P2);
+
+        cout << setw(12) << size;
+        for (unsigned int k = 0; k < count; k++)
+        {
+            if (!kernel::supported(kernels[k]))
+            {
+                cout << setw(12) << "-";
+                continue;
+            }
+
+            // enough pivots for about 1e8 element updates
+            unsigned int repeat = 1 + 100000000u / (rows * cols);
+
+            Tableau TS;
+            fill(TS, rows, cols);
+            clock_t start = clock();
+            for (unsigned int r = 0; r < repeat; r++)
+                kernel::eliminate(TS, rows, P1, P2, kernels[k]);
+            double ms = 1000.0 * (clock() - start) / CLOCKS_PER_SEC / repeat;
+
+            // one clean pivot for the checks
+            fill(TS, rows, cols);
+            kernel::eliminate(TS, rows, P1, P2, kernels[k]);
+
+            bool same = true;
+            if (k == 0)
+                scalar.swap(TS);
+            else
+                same = identical(TS, scalar);
+
+            cout << setw(11) << fixed << setprecision(3) << ms << (same ? " " : "!");
+        }
+        cout << setw(12) << setprecision(2) << difference(scalar, expected, original, P1, P2) << endl;
+    }
+
+    cout << "\n(! marks a kernel that differs from the scalar one)" << endl;
+
+    unsigned int max_threads = argc > 2 ? atoi(argv[2]) : std::thread::hardware_concurrency();
+    if (max_threads == 0)
+        max_threads = 1;
+
+    cout << "\n" << max_size << " x " << max_size << " LP, "
+        << kernel::name(kernel::best()) << " kernel\n\n"
+        << setw(12) << "threads"
+        << setw(12) << "ms/iter"
+        << setw(12) << "speedup"
+        << "\n";
+
+    double single = 0;
+    for (unsigned int threads = 1; ; threads *= 2)
+    {
+        if (threads > max_threads)
+            threads = max_threads;
+
+        Problem problem;
+        dense(problem, max_size, max_size);
+        problem.setThreads(threads);
+
+        unsigned int iterations;
+        double ms = iterate(problem, 20, iterations);
+
+        if (threads == 1)
+            single = ms;
+
+        cout
+            << setw(12) << problem.countThreads()
+            << setw(12) << setprecision(3) << ms
+            << setw(12) << setprecision(2) << single / ms
+            << endl;
+
+        if (threads == max_threads)
+            break;
+    }
+
+    unsigned int wide_rows = 64;
+    cout << "\n" << wide_rows << " constraints, solved to the optimum on 1 thread\n\n"
+        << setw(12) << "variables"
+        << setw(12) << "iterations"
+        << setw(12) << "tableau"
+        << setw(12) << "revised"
+        << setw(12) << "speedup"
+        << setw(12) << "rel. diff"
+        << "\n"
+        << setw(36) << "ms/iter"
+        << setw(12) << "ms/iter"
+        << "\n";
+
+    for (unsigned int cols = 1024; cols <= 8 * max_size; cols *= 2)
+    {
+        Problem tableau, revised;
+        dense(tableau, wide_rows, cols);
+        dense(revised, wide_rows, cols);
+        revised.setMethod(Problem::REVISED);
+
+        unsigned int iterations, revised_iterations;
+        double tableau_ms = iterate(tableau, 100000, iterations);
+        double revised_ms = iterate(revised, 100000, revised_iterations);
+
+        // both methods make the same pivots, so they reach the same vertex
+        double a = tableau.objectiveValue(), b = revised.objectiveValue();
+        bool same = iterations == revised_iterations && !tableau.error && !revised.error;
+
+        cout
+            << setw(12) << cols
+            << setw(12) << iterations
+            << setw(12) << setprecision(3) << tableau_ms
+            << setw(12) << revised_ms
+            << setw(12) << setprecision(2) << tableau_ms / revised_ms
+            << setw(11) << scientific << setprecision(1) << fabs(a - b) / fabs(a) << fixed << (same ? " " : "!")
+            << endl;
+    }
+
+    cout << "\n(! marks a run where the methods disagree)" << endl;
+
+    unsigned int pricing_cols = 2 * max_size;
+    cout << "\n" << wide_rows << " x " << pricing_cols << " LP, by pricing rule\n\n"
+        << setw(16) << "rule"
+        << setw(10) << "method"
+        << setw(12) << "iterations"
+        << setw(12) << "degenerate"
+        << setw(12) << "bland"
+        << setw(12) << "ms"
+        << "\n";
+
+    pricing::Rule rules[] = { pricing::DANTZIG, pricing::PARTIAL, pricing::DEVEX, pricing::STEEPEST_EDGE };
+    for (unsigned int r = 0; r < sizeof(rules) / sizeof(rules[0]); r++)
+    {
+        for (unsigned int method = Problem::TABLEAU; method <= Problem::REVISED; method++)
+        {
+            Problem problem;
+            dense(problem, wide_rows, pricing_cols);
+            problem.setMethod((Problem::Method)method);
+            problem.setPricing(rules[r]);
+
+            unsigned int iterations;
+            double ms = iterate(problem, 100000, iterations) * iterations;
+
+            cout
+                << setw(16) << pricing::name(rules[r])
+                << setw(10) << (method == Problem::TABLEAU ? "tableau" : "revised")
+                << setw(12) << problem.counters.pivots
+                << setw(12) << problem.counters.degenerate
+                << setw(12) << problem.counters.bland
+                << setw(12) << setprecision(2) << ms
+                << (problem.error ? " error" : "")
+                << endl;
+        }
+    }
+
+    unsigned int small_count = 100000;
+    cout << "\n" << small_count << " random LPs of each size, solved to the optimum\n\n"
+        << setw(12) << "size"
+        << setw(12) << "pivots"
+        << setw(12) << "problems"
+        << setw(12) << "batch"
+        << setw(12) << "speedup"
+        << "\n"
+        << setw(36) << "ms"
+        << setw(12) << "ms"
+        << "\n";
+
+    unsigned int small_sizes[] = { 2, 4, 8, 16 };
+    for (unsigned int s = 0; s < sizeof(small_sizes) / sizeof(small_sizes[0]); s++)
+    {
+        unsigned int size = small_sizes[s];
+
+        lcg_state = 12345;
+        std::vector<Problem> problems(small_count);
+        for (unsigned int i = 0; i < small_count; i++)
+            generate(problems[i], size, size);
+
+        // from the same unprepared problems: the batch copies them, the
+        // loop below prepares each one in place
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        Batch batch;
+        for (unsigned int i = 0; i < small_count; i++)
+            batch.add(problems[i]);
+        batch.Solve();
+        std::chrono::duration<double, std::milli> batch_ms = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        unsigned long pivots = 0;
+        for (unsigned int i = 0; i < small_count; i++)
+        {
+            unsigned int iterations;
+            problems[i].Prepare();
+            iterate(problems[i], 100000, iterations);
+            pivots += problems[i].counters.pivots;
+        }
+        std::chrono::duration<double, std::milli> problems_ms = std::chrono::steady_clock::now() - start;
+
+        bool same = pivots == batch.counters.pivots;
+        for (unsigned int i = 0; i < small_count && same; i++)
+        {
+            double a = problems[i].objectiveValue(), b = batch.objectiveValue(i);
+            same = problems[i].error == batch.hasFailed(i) && (problems[i].error || memcmp(&a, &b, sizeof(a)) == 0);
+        }
+
+        cout
+            << setw(12) << size
+            << setw(12) << pivots
+            << setw(12) << setprecision(1) << problems_ms.count()
+            << setw(12) << batch_ms.count()
+            << setw(11) << setprecision(2) << problems_ms.count() / batch_ms.count() << (same ? " " : "!")
+            << endl;
+    }
+
+    cout << "\n(! marks sizes where the batch and the problems disagree)" << endl;
+
+    unsigned int resolve_size = max_size / 4;
+    cout << "\n" << resolve_size << " x " << resolve_size << " LP, changed and solved again\n\n"
+        << setw(12) << "change"
+        << setw(12) << "warm"
+        << setw(12) << "warm"
+        << setw(12) << "cold"
+        << setw(12) << "cold"
+        << "\n"
+        << setw(24) << "pivots"
+        << setw(12) << "ms"
+        << setw(12) << "pivots"
+        << setw(12) << "ms"
+        << "\n";
+
+    Problem warm, cold;
+    dense(warm, resolve_size, resolve_size);
+    dense(cold, resolve_size, resolve_size);
+    unsigned int iterations;
+    iterate(warm, 100000, iterations);
+
+    for (unsigned int c = 0; c < 8; c++)
+    {
+        // odd: one more random constraint, even: constraint c down by 10%
+        if (c % 2)
+        {
+            std::vector<SparseMatrix::Entry> entries;
+            for (unsigned int j = 0; j < resolve_size; j++)
+                entries.push_back(SparseMatrix::Entry(j, 10.0 + next_random()));
+            warm.addConstraint(entries, 600.0 + 50.0 * next_random());
+        }
+        else
+        {
+            warm.setRhs(c, 0.9 * warm.constraints.rhs[c]);
+        }
+
+        unsigned long pivots = warm.counters.pivots;
+        double warm_ms = iterate(warm, 100000, iterations) * iterations;
+        pivots = warm.counters.pivots - pivots;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        cold.constraints = warm.constraints;
+        cold.setMethod(Problem::TABLEAU);
+        iterate(cold, 100000, iterations);
+        std::chrono::duration<double, std::milli> cold_ms = std::chrono::steady_clock::now() - start;
+
+        double a = warm.objectiveValue(), b = cold.objectiveValue();
+        bool same = warm.error == cold.error && (warm.error || fabs(a - b) <= 1e-9 * fabs(b));
+
+        cout
+            << setw(12) << (c % 2 ? "constraint" : "rhs")
+            << setw(12) << pivots
+            << setw(12) << setprecision(2) << warm_ms
+            << setw(12) << cold.counters.pivots
+            << setw(12) << cold_ms.count()
+            << (same ? " " : "!")
+            << endl;
+    }
+
+    cout << "\n(! marks changes after which the two disagree)" << endl;
+
+    unsigned int integer_rows = 15, integer_cols = 30;
+    cout << "\n" << integer_rows << " x " << integer_cols << " integer problem, branch and bound\n\n"
+        << setw(12) << "threads"
+        << setw(12) << "nodes"
+        << setw(12) << "ms"
+        << setw(12) << "nodes/s"
+        << setw(12) << "pivots"
+        << setw(12) << "optimum"
+        << "\n"
+        << setw(60) << "per node"
+        << "\n";
+
+    Problem integer;
+    dense(integer, integer_rows, integer_cols);
+    for (unsigned int j = 0; j < integer_cols; j++)
+        integer.integers.push_back(j);
+
+    double optimum = 0;
+    for (unsigned int threads = 1; ; threads *= 2)
+    {
+        if (threads > max_threads)
+            threads = max_threads;
+
+        BranchAndBound search;
+        search.threads = threads;
+        search.Solve(integer);
+        if (threads == 1)
+            optimum = search.objectiveValue();
+
+        cout
+            << setw(12) << threads
+            << setw(12) << search.counters.nodes
+            << setw(12) << setprecision(1) << search.seconds * 1000.0
+            << setw(12) << setprecision(0) << search.counters.nodes / search.seconds
+            << setw(12) << setprecision(2) << (double)search.counters.pivots / search.counters.nodes
+            << setw(11) << setprecision(1) << search.objectiveValue() << (fabs(search.objectiveValue() - optimum) <= 1e-9 * fabs(optimum) ? " " : "!")
+            << endl;
+
+        if (threads == max_threads)
+            break;
+    }
+
+    cout << "\n(! marks a run that found another optimum)" << endl;
+
+    return 0;
+}
@@ -0,0 +1,378 @@
+#ifndef SIMPLEX_BRANCH_H
+#define SIMPLEX_BRANCH_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include <math.h>
+#include "simplex-tools.h"
+#include "../common/thread-pool.h"
+
+namespace simplex
+{
+    // Integer variables closer than this to an integer count as integral
+    const double INTEGRALITY = 1e-6;
+
+    // Branch and bound for problems with integer variables
+    // (Problem::integers, the [INTEGER] section of the input).
+    //
+    // Every node is an LP solved by Problem. The root is the problem as
+    // read; a node whose optimum has integer variables at fractional values
+    // branches on the most fractional one, x_j = v, into x_j <= floor(v)
+    // and x_j >= ceil(v). Each child is a copy of its parent at its optimal
+    // basis plus that one constraint (Problem::copy(), addConstraint()), so
+    // it goes on from there by dual simplex, usually a few pivots away.
+    //
+    // The nodes are spread over the threads of a tools::ThreadPool, each with
+    // its own deque: a thread takes its newest node (depth first, which finds
+    // integer solutions early and keeps few nodes around) and, with none
+    // left, steals the oldest node of another thread (the largest subtree).
+    // The best integer solution so far, the incumbent, is shared: a node is
+    // dropped once its bound (the optimum of its parent, then its own) is
+    // not better than the incumbent by more than {gap}.
+    class BranchAndBound
+    {
+    public:
+        enum Status
+        {
+            OPTIMAL,        // within {gap}
+            NODE_LIMIT,     // stopped at {nodeLimit}: the incumbent, if any, is the best found
+            NO_SOLUTION     // no integer solution, or the LP has no optimum
+        };
+
+        struct Counters
+        {
+            unsigned long
+                nodes,      // LPs solved
+                pivots,     // ... and their pivots
+                incumbents; // integer solutions that were the best so far
+
+            Counters() :
+                nodes(0),
+                pivots(0),
+                incumbents(0)
+            {};
+        };
+
+        unsigned long
+            nodeLimit;  // 0: none
+        double
+            gap;        // relative to the incumbent, 0: the optimum
+        unsigned int
+            threads;    // as Problem::setThreads()
+
+        Status
+            status;
+        Counters
+            counters;
+        double
+            seconds;    // of the last Solve()
+
+        BranchAndBound() :
+            nodeLimit(0),
+            gap(0.0),
+            threads(1),
+            status(NO_SOLUTION),
+            seconds(0.0),
+            found(false),
+            best(0.0)
+        {};
+
+        // Solves {problem} (prepared) with its integer variables; the
+        // problem itself is left as it was
+        void Solve(Problem &problem)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            counters = Counters();
+            found = false;
+            best = 0.0;
+            x.clear();
+            integers = problem.integers;
+            stopping = false;
+            nodes = 0;
+            pivots = 0;
+            incumbents = 0;
+
+            tools::ThreadPool pool(threads);
+            workers.reset(new Worker[pool.size()]);
+
+            Node root;
+            root.problem = problem.copy();
+            if (problem.objective != Problem::VOID)
+            {
+                open = 1;
+                workers[0].nodes.push_back(std::move(root));
+
+                Search search(*this);
+                pool.run(search);
+            }
+
+            status = found ? OPTIMAL : NO_SOLUTION;
+            if (stopping)
+                status = NODE_LIMIT;
+            workers.reset();
+
+            counters.nodes = nodes;
+            counters.pivots = pivots;
+            counters.incumbents = incumbents;
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            seconds = elapsed.count();
+        }
+
+        bool hasSolution() { return found; }
+
+        // the "Function" value of result(), for the incumbent
+        double objectiveValue() { return best; }
+
+        // The incumbent: {x}[j - 1] for variable #j
+        const std::vector<double>& solution() { return x; }
+
+        void result()
+        {
+            if (!found)
+            {
+                std::cout << "No solution!" << std::endl;
+                return;
+            }
+
+            for (unsigned int j = 0; j < x.size(); j++)
+            {
+                if (x[j] != 0.0)
+                    std::cout << "Variable #" << j + 1 << ": " << x[j] << std::endl;
+            }
+            std::cout << "Function: " << best << std::endl;
+        }
+
+        void report(std::ostream &out)
+        {
+            const char *name[] = { "optimal", "node limit", "no solution" };
+            std::ios::fmtflags flags = out.flags();
+            std::streamsize precision = out.precision(6);
+            out.unsetf(std::ios::floatfield);
+            out << "Branch and bound: " << name[status] << ", "
+                << counters.nodes << " nodes in " << seconds << " s ("
+                << (seconds > 0.0 ? counters.nodes / seconds : 0.0) << " nodes/s, "
+                << (counters.nodes ? (double)counters.pivots / counters.nodes : 0.0) << " pivots per node), "
+                << counters.incumbents << " incumbents" << std::endl;
+            out.flags(flags);
+            out.precision(precision);
+        }
+
+    private:
+        struct Node
+        {
+            Problem
+                problem;    // at its parent's optimum, with the new constraint
+            double
+                bound;      // its parent's optimum
+
+            Node() :
+                bound(HUGE_VAL)
+            {};
+
+            Node(Node &&other) :
+                problem(std::move(other.problem)),
+                bound(other.bound)
+            {};
+
+            Node& operator=(Node &&other)
+            {
+                problem = std::move(other.problem);
+                bound = other.bound;
+                return *this;
+            }
+        };
+
+        struct Worker
+        {
+            std::mutex
+                lock;
+            std::deque<Node>
+                nodes;
+        };
+
+        class Search :
+            public tools::ThreadPool::Job
+        {
+        public:
+            Search(BranchAndBound &_search) :
+                search(_search)
+            {};
+
+            void run(unsigned int part, unsigned int parts)
+            {
+                search.work(part, parts);
+            }
+
+        private:
+            BranchAndBound
+                &search;
+        };
+
+        std::vector<unsigned int>
+            integers;
+        std::unique_ptr<Worker[]>
+            workers;
+        std::atomic<unsigned long>
+            open,       // nodes in a deque or being solved
+            nodes,
+            pivots,
+            incumbents;
+        std::atomic<bool>
+            stopping;
+
+        std::mutex
+            lock;       // of the incumbent
+        std::atomic<bool>
+            found;
+        std::atomic<double>
+            best;
+        std::vector<double>
+            x;
+
+        void work(unsigned int part, unsigned int parts)
+        {
+            Node node;
+            while (!stopping)
+            {
+                if (!take(part, parts, node))
+                {
+                    if (open == 0)
+                        break;
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                solve(node, part);
+                open--;
+            }
+        }
+
+        // The newest node of {part}, or the oldest of another one
+        bool take(unsigned int part, unsigned int parts, Node &node)
+        {
+            for (unsigned int i = 0; i < parts; i++)
+            {
+                Worker &w = workers[(part + i) % parts];
+                std::lock_guard<std::mutex> guard(w.lock);
+                if (w.nodes.empty())
+                    continue;
+
+                if (i == 0)
+                {
+                    node = std::move(w.nodes.back());
+                    w.nodes.pop_back();
+                }
+                else
+                {
+                    node = std::move(w.nodes.front());
+                    w.nodes.pop_front();
+                }
+                return true;
+            }
+            return false;
+        }
+
+        // Is {bound} better than the incumbent by more than the gap?
+        bool improves(double bound)
+        {
+            if (!found)
+                return true;
+            double incumbent = best;
+            return bound > incumbent + std::max(gap * fabs(incumbent), TOLERANCE);
+        }
+
+        void solve(Node &node, unsigned int part)
+        {
+            if (!improves(node.bound))
+                return;
+            if (nodeLimit && nodes >= nodeLimit)
+            {
+                stopping = true;
+                return;
+            }
+            nodes++;
+
+            Problem &p = node.problem;
+            unsigned long before = p.counters.pivots;
+            while (!p.isOptimal && !p.error)
+            {
+                p.Pivot();
+                p.Formula();
+                p.Optimize();
+            }
+            pivots += p.counters.pivots - before;
+
+            double bound = p.objectiveValue();
+            if (p.error || !improves(bound))
+                return;
+
+            // the most fractional integer variable
+            std::vector<double> values;
+            p.solution(values);
+            unsigned int j = 0;
+            double fraction = 0.0;
+            for (std::size_t i = 0; i < integers.size(); i++)
+            {
+                double v = values[integers[i]];
+                double f = fabs(v - floor(v + 0.5));
+                if (f > INTEGRALITY && f > fraction)
+                {
+                    j = integers[i];
+                    fraction = f;
+                }
+            }
+
+            if (fraction == 0.0)
+            {
+                for (std::size_t i = 0; i < integers.size(); i++)
+                    values[integers[i]] = floor(values[integers[i]] + 0.5);
+                offer(bound, values);
+                return;
+            }
+
+            double v = values[j];
+            Node down;
+            down.problem = p.copy();
+            down.bound = bound;
+            down.problem.addConstraint(std::vector<SparseMatrix::Entry>(1, SparseMatrix::Entry(j, 1.0)), floor(v));
+            node.bound = bound;
+            node.problem.addConstraint(std::vector<SparseMatrix::Entry>(1, SparseMatrix::Entry(j, -1.0)), -ceil(v));
+
+            // the side v is nearer to is taken first
+            open += 2;
+            Worker &w = workers[part];
+            std::lock_guard<std::mutex> guard(w.lock);
+            if (v - floor(v) < 0.5)
+            {
+                w.nodes.push_back(std::move(node));
+                w.nodes.push_back(std::move(down));
+            }
+            else
+            {
+                w.nodes.push_back(std::move(down));
+                w.nodes.push_back(std::move(node));
+            }
+        }
+
+        void offer(double value, std::vector<double> &values)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (found && value <= best)
+                return;
+
+            x.swap(values);
+            best = value;
+            found = true;
+            incumbents++;
+        }
+    };
+}
+
+#endif
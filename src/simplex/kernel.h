@@ -0,0 +1,444 @@
+#ifndef SIMPLEX_KERNEL_H
+#define SIMPLEX_KERNEL_H
+
+#include <cstddef>
+#include <math.h>
+
+#include "tableau.h"
+
+// Vector kernels for the pivot update of the tableau, picked at run time
+// (and, further down, for the batch engine in batch.h).
+//
+// Each kernel computes row[j] -= f * pivot[j] over whole (padded, aligned)
+// rows with a separate multiply and subtract, never a fused one, so every
+// kernel gives bit for bit the same tableau as the SCALAR one.
+//
+// The former Formula() computed TS[I][J] -= TS[P1][J] * TS[I][P2] / TS[P1][P2]
+// with a division per element; the kernels multiply by the hoisted factor
+// TS[I][P2] * (1 / TS[P1][P2]) instead. The two differ by rounding only: per
+// pivot, by at most 5 units in the last place of the larger of the
+// element and the subtracted term (about 1.1e-15 times its magnitude).
+
+// GCC fuses a multiply and a subtract into an FMA wherever the target has
+// one (AVX-512 always does), which rounds once instead of twice
+#if defined(__GNUC__) && !defined(__clang__)
+#define SIMPLEX_SEPARATE __attribute__((optimize("fp-contract=off")))
+#else
+#define SIMPLEX_SEPARATE
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define SIMPLEX_TARGET(isa)
+#define SIMPLEX_SSE2
+#define SIMPLEX_AVX
+#elif (defined(__x86_64__) || defined(__i386__)) && (defined(__clang__) || __GNUC__ >= 5)
+#include <immintrin.h>
+#define SIMPLEX_TARGET(isa) __attribute__((target(isa))) SIMPLEX_SEPARATE
+#define SIMPLEX_SSE2
+#define SIMPLEX_AVX
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SIMPLEX_TARGET(isa)
+#define SIMPLEX_SSE2
+#endif
+
+namespace simplex
+{
+    namespace kernel
+    {
+        enum Kernel
+        {
+            SCALAR,
+            SSE2,
+            AVX2,
+            AVX512,
+            BEST        // the widest one this machine runs
+        };
+
+        inline const char* name(Kernel k)
+        {
+            switch (k)
+            {
+            case SCALAR: return "scalar";
+            case SSE2: return "sse2";
+            case AVX2: return "avx2";
+            case AVX512: return "avx512";
+            default: return "best";
+            }
+        }
+
+        inline bool supported(Kernel k)
+        {
+            switch (k)
+            {
+            case SCALAR:
+                return true;
+#if defined(SIMPLEX_SSE2)
+            case SSE2:
+                return true;    // part of every x86-64, assumed on x86
+#endif
+#if defined(SIMPLEX_AVX) && defined(_MSC_VER)
+            case AVX2:
+            case AVX512:
+            {
+                int info[4];
+                __cpuid(info, 1);
+                bool osxsave = (info[2] & (1 << 27)) != 0;
+                if (!osxsave)
+                    return false;
+
+                unsigned long long xcr0 = _xgetbv(0);
+                __cpuidex(info, 7, 0);
+                if (k == AVX2)
+                    return (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+                return (xcr0 & 0xE6) == 0xE6 && (info[1] & (1 << 16)) != 0;
+            }
+#elif defined(SIMPLEX_AVX)
+            case AVX2:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx2") != 0;
+            case AVX512:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx512f") != 0;
+#endif
+            default:
+                return false;
+            }
+        }
+
+        inline Kernel best()
+        {
+            static Kernel k = supported(AVX512) ? AVX512 : (supported(AVX2) ? AVX2 : (supported(SSE2) ? SSE2 : SCALAR));
+            return k;
+        }
+
+        // row[j] -= f * pivot[j], for j < n
+        SIMPLEX_SEPARATE
+        inline void updateScalar(double *row, const double *pivot, double f, std::size_t n)
+        {
+            for (std::size_t j = 0; j < n; j++)
+                row[j] -= f * pivot[j];
+        }
+
+#if defined(SIMPLEX_SSE2)
+        // {n} is a multiple of 8 and both rows are 64 byte aligned
+        SIMPLEX_TARGET("sse2")
+        inline void updateSSE2(double *row, const double *pivot, double f, std::size_t n)
+        {
+            __m128d vf = _mm_set1_pd(f);
+            for (std::size_t j = 0; j < n; j += 2)
+            {
+                __m128d p = _mm_load_pd(pivot + j);
+                _mm_store_pd(row + j, _mm_sub_pd(_mm_load_pd(row + j), _mm_mul_pd(p, vf)));
+            }
+        }
+#endif
+
+#if defined(SIMPLEX_AVX)
+        SIMPLEX_TARGET("avx2")
+        inline void updateAVX2(double *row, const double *pivot, double f, std::size_t n)
+        {
+            __m256d vf = _mm256_set1_pd(f);
+            for (std::size_t j = 0; j < n; j += 4)
+            {
+                __m256d p = _mm256_load_pd(pivot + j);
+                _mm256_store_pd(row + j, _mm256_sub_pd(_mm256_load_pd(row + j), _mm256_mul_pd(p, vf)));
+            }
+        }
+
+        SIMPLEX_TARGET("avx512f")
+        inline void updateAVX512(double *row, const double *pivot, double f, std::size_t n)
+        {
+            __m512d vf = _mm512_set1_pd(f);
+            for (std::size_t j = 0; j < n; j += 8)
+            {
+                __m512d p = _mm512_load_pd(pivot + j);
+                _mm512_store_pd(row + j, _mm512_sub_pd(_mm512_load_pd(row + j), _mm512_mul_pd(p, vf)));
+            }
+        }
+#endif
+
+        inline void update(Kernel k, double *row, const double *pivot, double f, std::size_t n)
+        {
+            switch (k)
+            {
+#if defined(SIMPLEX_AVX)
+            case AVX512: updateAVX512(row, pivot, f, n); break;
+            case AVX2: updateAVX2(row, pivot, f, n); break;
+#endif
+#if defined(SIMPLEX_SSE2)
+            case SSE2: updateSSE2(row, pivot, f, n); break;
+#endif
+            default: updateScalar(row, pivot, f, n); break;
+            }
+        }
+
+        // The same with a factor per element, for the batch engine where
+        // element j belongs to problem j: row[j] -= f[j] * pivot[j], except
+        // where f[j] is 0 (that row is skipped, as eliminateRows() does)
+        SIMPLEX_SEPARATE
+        inline void updateLanesScalar(double *row, const double *f, const double *pivot, std::size_t n)
+        {
+            for (std::size_t j = 0; j < n; j++)
+            {
+                if (f[j] != 0.0)
+                    row[j] -= f[j] * pivot[j];
+            }
+        }
+
+#if defined(SIMPLEX_SSE2)
+        SIMPLEX_TARGET("sse2")
+        inline void updateLanesSSE2(double *row, const double *f, const double *pivot, std::size_t n)
+        {
+            __m128d zero = _mm_setzero_pd();
+            for (std::size_t j = 0; j < n; j += 2)
+            {
+                __m128d vf = _mm_load_pd(f + j);
+                __m128d r = _mm_load_pd(row + j);
+                __m128d u = _mm_sub_pd(r, _mm_mul_pd(vf, _mm_load_pd(pivot + j)));
+                __m128d keep = _mm_cmpneq_pd(vf, zero);
+                _mm_store_pd(row + j, _mm_or_pd(_mm_and_pd(keep, u), _mm_andnot_pd(keep, r)));
+            }
+        }
+#endif
+
+#if defined(SIMPLEX_AVX)
+        SIMPLEX_TARGET("avx2")
+        inline void updateLanesAVX2(double *row, const double *f, const double *pivot, std::size_t n)
+        {
+            __m256d zero = _mm256_setzero_pd();
+            for (std::size_t j = 0; j < n; j += 4)
+            {
+                __m256d vf = _mm256_load_pd(f + j);
+                __m256d r = _mm256_load_pd(row + j);
+                __m256d u = _mm256_sub_pd(r, _mm256_mul_pd(vf, _mm256_load_pd(pivot + j)));
+                _mm256_store_pd(row + j, _mm256_blendv_pd(r, u, _mm256_cmp_pd(vf, zero, _CMP_NEQ_UQ)));
+            }
+        }
+
+        SIMPLEX_TARGET("avx512f")
+        inline void updateLanesAVX512(double *row, const double *f, const double *pivot, std::size_t n)
+        {
+            __m512d zero = _mm512_setzero_pd();
+            for (std::size_t j = 0; j < n; j += 8)
+            {
+                __m512d vf = _mm512_load_pd(f + j);
+                __m512d r = _mm512_load_pd(row + j);
+                __mmask8 keep = _mm512_cmp_pd_mask(vf, zero, _CMP_NEQ_UQ);
+                _mm512_store_pd(row + j, _mm512_mask_sub_pd(r, keep, r, _mm512_mul_pd(vf, _mm512_load_pd(pivot + j))));
+            }
+        }
+#endif
+
+        inline void updateLanes(Kernel k, double *row, const double *f, const double *pivot, std::size_t n)
+        {
+            switch (k)
+            {
+#if defined(SIMPLEX_AVX)
+            case AVX512: updateLanesAVX512(row, f, pivot, n); break;
+            case AVX2: updateLanesAVX2(row, f, pivot, n); break;
+#endif
+#if defined(SIMPLEX_SSE2)
+            case SSE2: updateLanesSSE2(row, f, pivot, n); break;
+#endif
+            default: updateLanesScalar(row, f, pivot, n); break;
+            }
+        }
+
+        // Pricing and ratio test of the batch engine, one problem per element:
+        // where value[j] > best[j] (never for a NaN), best[j] = value[j]
+        // and which[j] = index
+        inline void largestScalar(double *best, double *which, const double *value, double index, std::size_t n)
+        {
+            for (std::size_t j = 0; j < n; j++)
+            {
+                if (value[j] > best[j])
+                {
+                    best[j] = value[j];
+                    which[j] = index;
+                }
+            }
+        }
+
+        // ... and where column[j] < 0 and |rhs[j] / column[j]| < best[j],
+        // best[j] = that ratio and which[j] = index
+        inline void ratioScalar(double *best, double *which, const double *rhs, const double *column, double index, std::size_t n)
+        {
+            for (std::size_t j = 0; j < n; j++)
+            {
+                if (!(column[j] < 0.0))
+                    continue;
+
+                double V = fabs(rhs[j] / column[j]);
+                if (V < best[j])
+                {
+                    best[j] = V;
+                    which[j] = index;
+                }
+            }
+        }
+
+#if defined(SIMPLEX_SSE2)
+        SIMPLEX_TARGET("sse2")
+        inline void largestSSE2(double *best, double *which, const double *value, double index, std::size_t n)
+        {
+            __m128d vi = _mm_set1_pd(index);
+            for (std::size_t j = 0; j < n; j += 2)
+            {
+                __m128d v = _mm_load_pd(value + j);
+                __m128d b = _mm_load_pd(best + j);
+                __m128d take = _mm_cmpgt_pd(v, b);
+                _mm_store_pd(best + j, _mm_or_pd(_mm_and_pd(take, v), _mm_andnot_pd(take, b)));
+                _mm_store_pd(which + j, _mm_or_pd(_mm_and_pd(take, vi), _mm_andnot_pd(take, _mm_load_pd(which + j))));
+            }
+        }
+
+        SIMPLEX_TARGET("sse2")
+        inline void ratioSSE2(double *best, double *which, const double *rhs, const double *column, double index, std::size_t n)
+        {
+            __m128d vi = _mm_set1_pd(index);
+            __m128d zero = _mm_setzero_pd();
+            __m128d sign = _mm_set1_pd(-0.0);
+            for (std::size_t j = 0; j < n; j += 2)
+            {
+                __m128d c = _mm_load_pd(column + j);
+                __m128d b = _mm_load_pd(best + j);
+                __m128d V = _mm_andnot_pd(sign, _mm_div_pd(_mm_load_pd(rhs + j), c));
+                __m128d take = _mm_and_pd(_mm_cmplt_pd(c, zero), _mm_cmplt_pd(V, b));
+                _mm_store_pd(best + j, _mm_or_pd(_mm_and_pd(take, V), _mm_andnot_pd(take, b)));
+                _mm_store_pd(which + j, _mm_or_pd(_mm_and_pd(take, vi), _mm_andnot_pd(take, _mm_load_pd(which + j))));
+            }
+        }
+#endif
+
+#if defined(SIMPLEX_AVX)
+        SIMPLEX_TARGET("avx2")
+        inline void largestAVX2(double *best, double *which, const double *value, double index, std::size_t n)
+        {
+            __m256d vi = _mm256_set1_pd(index);
+            for (std::size_t j = 0; j < n; j += 4)
+            {
+                __m256d v = _mm256_load_pd(value + j);
+                __m256d b = _mm256_load_pd(best + j);
+                __m256d take = _mm256_cmp_pd(v, b, _CMP_GT_OQ);
+                _mm256_store_pd(best + j, _mm256_blendv_pd(b, v, take));
+                _mm256_store_pd(which + j, _mm256_blendv_pd(_mm256_load_pd(which + j), vi, take));
+            }
+        }
+
+        SIMPLEX_TARGET("avx2")
+        inline void ratioAVX2(double *best, double *which, const double *rhs, const double *column, double index, std::size_t n)
+        {
+            __m256d vi = _mm256_set1_pd(index);
+            __m256d zero = _mm256_setzero_pd();
+            __m256d sign = _mm256_set1_pd(-0.0);
+            for (std::size_t j = 0; j < n; j += 4)
+            {
+                __m256d c = _mm256_load_pd(column + j);
+                __m256d b = _mm256_load_pd(best + j);
+                __m256d V = _mm256_andnot_pd(sign, _mm256_div_pd(_mm256_load_pd(rhs + j), c));
+                __m256d take = _mm256_and_pd(_mm256_cmp_pd(c, zero, _CMP_LT_OQ), _mm256_cmp_pd(V, b, _CMP_LT_OQ));
+                _mm256_store_pd(best + j, _mm256_blendv_pd(b, V, take));
+                _mm256_store_pd(which + j, _mm256_blendv_pd(_mm256_load_pd(which + j), vi, take));
+            }
+        }
+
+        SIMPLEX_TARGET("avx512f")
+        inline void largestAVX512(double *best, double *which, const double *value, double index, std::size_t n)
+        {
+            __m512d vi = _mm512_set1_pd(index);
+            for (std::size_t j = 0; j < n; j += 8)
+            {
+                __m512d v = _mm512_load_pd(value + j);
+                __mmask8 take = _mm512_cmp_pd_mask(v, _mm512_load_pd(best + j), _CMP_GT_OQ);
+                _mm512_mask_store_pd(best + j, take, v);
+                _mm512_mask_store_pd(which + j, take, vi);
+            }
+        }
+
+        SIMPLEX_TARGET("avx512f")
+        inline void ratioAVX512(double *best, double *which, const double *rhs, const double *column, double index, std::size_t n)
+        {
+            __m512d vi = _mm512_set1_pd(index);
+            __m512d zero = _mm512_setzero_pd();
+            for (std::size_t j = 0; j < n; j += 8)
+            {
+                __m512d c = _mm512_load_pd(column + j);
+                __mmask8 negative = _mm512_cmp_pd_mask(c, zero, _CMP_LT_OQ);
+                __m512d V = _mm512_abs_pd(_mm512_maskz_div_pd(negative, _mm512_load_pd(rhs + j), c));
+                __mmask8 take = _mm512_mask_cmp_pd_mask(negative, V, _mm512_load_pd(best + j), _CMP_LT_OQ);
+                _mm512_mask_store_pd(best + j, take, V);
+                _mm512_mask_store_pd(which + j, take, vi);
+            }
+        }
+#endif
+
+        inline void largest(Kernel k, double *best, double *which, const double *value, double index, std::size_t n)
+        {
+            switch (k)
+            {
+#if defined(SIMPLEX_AVX)
+            case AVX512: largestAVX512(best, which, value, index, n); break;
+            case AVX2: largestAVX2(best, which, value, index, n); break;
+#endif
+#if defined(SIMPLEX_SSE2)
+            case SSE2: largestSSE2(best, which, value, index, n); break;
+#endif
+            default: largestScalar(best, which, value, index, n); break;
+            }
+        }
+
+        inline void ratio(Kernel k, double *best, double *which, const double *rhs, const double *column, double index, std::size_t n)
+        {
+            switch (k)
+            {
+#if defined(SIMPLEX_AVX)
+            case AVX512: ratioAVX512(best, which, rhs, column, index, n); break;
+            case AVX2: ratioAVX2(best, which, rhs, column, index, n); break;
+#endif
+#if defined(SIMPLEX_SSE2)
+            case SSE2: ratioSSE2(best, which, rhs, column, index, n); break;
+#endif
+            default: ratioScalar(best, which, rhs, column, index, n); break;
+            }
+        }
+
+        // Eliminates column {P2} from rows [first, last) of the tableau,
+        // skipping the pivot row {P1}, using the pivot TS[P1][P2]. Column 0
+        // (the labels) and the pivot column itself are left untouched; the
+        // caller scales them afterwards.
+        inline void eliminateRows(Tableau &TS, unsigned int first, unsigned int last, unsigned int P1, unsigned int P2, Kernel k)
+        {
+            if (k == BEST || !supported(k))
+                k = best();
+
+            double inverse = 1.0 / TS[P1][P2];
+            const double *pivot = TS[P1];
+            std::size_t n = TS.stride();
+
+            for (unsigned int I = first; I < last; I++)
+            {
+                double *row = TS[I];
+                double column = row[P2];
+                if (I == P1 || column == 0.0)
+                    continue;
+
+                // whole rows are updated, the two columns are put back after
+                double label = row[0];
+                update(k, row, pivot, column * inverse, n);
+                row[0] = label;
+                row[P2] = column;
+            }
+        }
+
+        // The same over rows 1 .. {rows} - 1 (row 0 holds the labels)
+        inline void eliminate(Tableau &TS, unsigned int rows, unsigned int P1, unsigned int P2, Kernel k = BEST)
+        {
+            eliminateRows(TS, 1, rows, P1, P2, k);
+        }
+    }
+}
+
+#endif
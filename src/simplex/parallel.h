@@ -0,0 +1,164 @@
+#ifndef SIMPLEX_PARALLEL_H
+#define SIMPLEX_PARALLEL_H
+
+#include <math.h>
+#include <stdint.h>
+
+#include "tableau.h"
+#include "kernel.h"
+#include "../common/thread-pool.h"
+
+namespace simplex
+{
+    // Row-parallel pieces of a simplex iteration, run on a tools::ThreadPool.
+    //
+    // Both the pivot update and the ratio test split the tableau into
+    // contiguous blocks of rows, one per part. Tableau rows start on their
+    // own cache line, so two parts never write to the same line, and each
+    // part reports its result once, into a slot of a whole cache line.
+    namespace parallel
+    {
+        enum
+        {
+            MIN_ELEMENTS = 1 << 16  // smaller tableaux are not worth splitting
+        };
+
+        // Rows [begin, end) of [first, last) that belong to {part} of {parts}
+        inline void split(unsigned int first, unsigned int last, unsigned int part, unsigned int parts, unsigned int &begin, unsigned int &end)
+        {
+            unsigned int n = last - first;
+            begin = first + (unsigned int)((unsigned long long)n * part / parts);
+            end = first + (unsigned int)((unsigned long long)n * (part + 1) / parts);
+        }
+
+        // Ratio test over rows [first, last): the row with the smallest
+        // |TS[I][1] / TS[I][P2]| among those with TS[I][P2] < 0, below
+        // {ratio}. On a tie the first row wins. {ratio} and {row} are only
+        // changed when such a row is found.
+        inline void ratioTest(const Tableau &TS, unsigned int first, unsigned int last, unsigned int P2, double &ratio, unsigned int &row)
+        {
+            for (unsigned int I = first; I < last; I++)
+            {
+                if (TS[I][P2] >= 0.0)
+                    continue;
+
+                double V = fabs(TS[I][1] / TS[I][P2]);
+                if (V < ratio)
+                {
+                    ratio = V;
+                    row = I;
+                }
+            }
+        }
+
+        class RatioTest :
+            public tools::ThreadPool::Job
+        {
+        public:
+            RatioTest(const Tableau &_TS, unsigned int _first, unsigned int _last, unsigned int _P2, unsigned int _parts) :
+                TS(_TS),
+                first(_first),
+                last(_last),
+                P2(_P2),
+                slots(_parts),
+                _block(new char[_parts * sizeof(Result) + Tableau::ALIGNMENT])
+            {
+                // aligned as the tableau rows, so each slot is one cache line
+                results = (Result*)(((uintptr_t)_block + Tableau::ALIGNMENT - 1) & ~(uintptr_t)(Tableau::ALIGNMENT - 1));
+                for (unsigned int part = 0; part < slots; part++)
+                {
+                    results[part].ratio = HUGE_VAL;
+                    results[part].row = 0;
+                }
+            };
+
+            ~RatioTest()
+            {
+                delete[] _block;
+            };
+
+            void run(unsigned int part, unsigned int parts)
+            {
+                unsigned int begin, end;
+                split(first, last, part, parts, begin, end);
+
+                double ratio = results[part].ratio;
+                unsigned int row = 0;
+                ratioTest(TS, begin, end, P2, ratio, row);
+
+                results[part].ratio = ratio;
+                results[part].row = row;
+            }
+
+            // Merges the parts in row order, so the result is the one of
+            // the sequential ratioTest()
+            void merge(double &ratio, unsigned int &row)
+            {
+                for (unsigned int part = 0; part < slots; part++)
+                {
+                    if (results[part].row && results[part].ratio < ratio)
+                    {
+                        ratio = results[part].ratio;
+                        row = results[part].row;
+                    }
+                }
+            }
+
+        private:
+            struct Result
+            {
+                double ratio;
+                unsigned int row;   // 0 if none
+                char padding[Tableau::ALIGNMENT - sizeof(double) - sizeof(unsigned int)];
+            };
+
+            const Tableau
+                &TS;
+            unsigned int
+                first,
+                last,
+                P2,
+                slots;      // parts, one Result each
+            char
+                *_block;    // as allocated
+            Result
+                *results;   // _block, aligned
+
+            RatioTest(const RatioTest &);
+            RatioTest& operator=(const RatioTest &);
+        };
+
+        // kernel::eliminateRows() over the rows of each part
+        class Eliminate :
+            public tools::ThreadPool::Job
+        {
+        public:
+            Eliminate(Tableau &_TS, unsigned int _rows, unsigned int _P1, unsigned int _P2, kernel::Kernel _k) :
+                TS(_TS),
+                rows(_rows),
+                P1(_P1),
+                P2(_P2),
+                k(_k)
+            {};
+
+            void run(unsigned int part, unsigned int parts)
+            {
+                unsigned int begin, end;
+                split(1, rows, part, parts, begin, end);
+                kernel::eliminateRows(TS, begin, end, P1, P2, k);
+            }
+
+        private:
+            Tableau
+                &TS;
+            unsigned int
+                rows,
+                P1,
+                P2;
+            kernel::Kernel
+                k;
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,490 @@
+#ifndef SIMPLEX_PRESOLVE_H
+#define SIMPLEX_PRESOLVE_H
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <math.h>
+
+#include "sparse.h"
+#include "revised.h"
+
+namespace simplex
+{
+    // Presolve for: maximize (or minimize) c x + c0 s.t. A x <= b, x >= 0,
+    // run on the variables and constraints of a problem before Prepare().
+    //
+    // Until nothing changes (or MAX_PASSES), it
+    //  - drops the rows no x >= 0 can break: empty ones with b_i >= 0, all
+    //    a_ij <= 0 with b_i >= 0, all a_ij >= 0 with sum a_ij u_j <= b_i;
+    //  - turns singleton rows into bounds: a x_j <= b_i with a > 0 is the
+    //    upper bound u_j = b_i / a (only the tightest is kept, as a row at
+    //    the end, and not even that if a row that stays implies it), with
+    //    a < 0 and b_i < 0 the lower bound b_i / a, which x_j is shifted by;
+    //  - fixes, and removes, the variables a row forces to 0 (all a_ij >= 0
+    //    and b_i = 0), those with u_j = 0, and those the objective drives to
+    //    a bound no row holds back: to 0 if no entry is negative and the
+    //    cost does not improve, to u_j if no entry is positive and it does.
+    // Then it scales the rows and columns that are left by the powers of 2
+    // nearest to 1 / the geometric mean of their largest and smallest entry,
+    // SCALE_PASSES times each, which narrows the range of A without any
+    // rounding.
+    //
+    // Postsolve: x_j = shift_j + scale_j x'_j for the variables that are
+    // left, the value it was fixed at for the others; the objective value
+    // does not change. A problem found infeasible or unbounded, or with no
+    // variable left, is left as it was, for the simplex to solve.
+    class Presolve
+    {
+    public:
+        enum
+        {
+            MAX_PASSES = 16,
+            SCALE_PASSES = 4
+        };
+
+        enum Status
+        {
+            REDUCED,
+            INFEASIBLE,     // ... as far as presolve can tell: left as it was
+            UNBOUNDED,      // (if feasible)
+            EMPTY,          // all the variables are fixed
+            INTEGER         // integer variables: not presolved
+        };
+
+        // What presolve did, for the log
+        struct Report
+        {
+            Status
+                status;
+            unsigned int
+                rows,
+                columns,
+                presolvedRows,
+                presolvedColumns,
+                redundant,  // rows dropped
+                bounds,     // singleton rows taken as bounds
+                fixed;      // columns removed
+            std::size_t
+                nonZeros,
+                presolvedNonZeros;
+            double
+                range,          // largest / smallest |a_ij|
+                scaledRange;
+
+            Report() :
+                status(REDUCED),
+                rows(0),
+                columns(0),
+                presolvedRows(0),
+                presolvedColumns(0),
+                redundant(0),
+                bounds(0),
+                fixed(0),
+                nonZeros(0),
+                presolvedNonZeros(0),
+                range(1.0),
+                scaledRange(1.0)
+            {};
+
+            void print(std::ostream &out) const
+            {
+                out << "Presolve: " << rows << " x " << columns << " (" << nonZeros << " non-zeros)";
+                if (status != REDUCED)
+                {
+                    const char *why[] = { "", "infeasible", "unbounded", "no variable left", "integer variables" };
+                    out << " left as it was: " << why[status] << std::endl;
+                    return;
+                }
+
+                std::ios::fmtflags flags = out.flags();
+                std::streamsize precision = out.precision(1);
+                out << " -> " << presolvedRows << " x " << presolvedColumns << " (" << presolvedNonZeros << " non-zeros), "
+                    << redundant << " rows dropped, " << bounds << " bounds, " << fixed << " variables fixed, "
+                    << "coefficient range " << std::scientific << range << " -> " << scaledRange << std::endl;
+                out.flags(flags);
+                out.precision(precision);
+            }
+        };
+
+        Report
+            report;
+
+        Presolve() :
+            applied(false)
+        {};
+
+        // Has it changed the problem (else postsolve is the identity)?
+        bool isApplied() const { return applied; }
+
+        // Reduces and scales {variables} (the costs, then c0) and
+        // {constraints} in place; {objective} is 1 to maximize, -1 to
+        // minimize. Shifts and scaling would break {integers}, so then it
+        // only reports the size. Returns isApplied().
+        bool apply(std::vector<double> &variables, SparseMatrix &constraints, int objective, bool integers = false)
+        {
+            n = (unsigned int)variables.size() - 1;
+            unsigned int m = constraints.rows();
+
+            report = Report();
+            report.rows = m;
+            report.columns = n;
+            report.nonZeros = constraints.nonZeros();
+            report.range = range(constraints.value);
+            if (integers)
+            {
+                report.status = INTEGER;
+                return applied = false;
+            }
+
+            c.assign(variables.begin(), variables.end() - 1);
+            c0 = variables[n];
+            b = constraints.rhs;
+            shift.assign(n, 0.0);
+            upper.assign(n, HUGE_VAL);
+            value.assign(n, 0.0);
+            column.assign(n, true);
+            row.assign(m, true);
+            constraints.transpose(byColumns, n);
+
+            reduce(constraints, objective);
+            if (report.status == REDUCED && std::find(column.begin(), column.end(), true) == column.end())
+                report.status = EMPTY;
+            if (report.status != REDUCED)
+                return applied = false;
+
+            rebuild(variables, constraints);
+            scale(variables, constraints);
+
+            report.presolvedRows = constraints.rows();
+            report.presolvedColumns = (unsigned int)variables.size() - 1;
+            report.presolvedNonZeros = constraints.nonZeros();
+            report.scaledRange = range(constraints.value);
+            return applied = true;
+        }
+
+        unsigned int NumberOfVariables() const { return n; }    // before presolve
+
+        // Value of the variable {j} (from 0) of the problem before presolve,
+        // from the values {x} of those of the presolved one
+        double postsolve(unsigned int j, const std::vector<double> &x) const
+        {
+            if (!applied)
+                return x[j];
+            if (index[j] == NONE)
+                return value[j];
+            return shift[j] + scaling[index[j]] * x[index[j]];
+        }
+
+        // The variable of the presolved problem {j} stands for, if any
+        bool isKept(unsigned int j) const { return !applied || index[j] != NONE; }
+
+        unsigned int presolvedIndex(unsigned int j) const { return applied ? index[j] : j; }
+
+    private:
+        enum
+        {
+            NONE = 0xFFFFFFFF
+        };
+
+        bool
+            applied;
+        unsigned int
+            n;
+        SparseMatrix
+            byColumns;
+        std::vector<double>
+            c,
+            b,
+            shift,      // lower bounds moved to 0
+            upper,      // of each (shifted) variable, HUGE_VAL if none
+            value,      // of the fixed variables
+            scaling;    // of the columns left
+        double
+            c0;
+        std::vector<bool>
+            column,     // still in the problem?
+            row;
+        std::vector<unsigned int>
+            index;      // of each variable in the presolved problem, NONE if fixed
+
+        static double range(const std::vector<double> &a)
+        {
+            double low = HUGE_VAL, high = 0.0;
+            for (std::size_t e = 0; e < a.size(); e++)
+            {
+                low = std::min(low, fabs(a[e]));
+                high = std::max(high, fabs(a[e]));
+            }
+            return a.empty() ? 1.0 : high / low;
+        }
+
+        static double nearestPowerOf2(double v)
+        {
+            return ldexp(1.0, (int)floor(log2(v) + 0.5));
+        }
+
+        // x_j = {v} from now on (in shifted terms)
+        void fix(unsigned int j, double v)
+        {
+            move(j, v);
+            value[j] = shift[j];
+            column[j] = false;
+            report.fixed++;
+        }
+
+        // x_j = {v} + x_j' (a new lower bound)
+        void move(unsigned int j, double v)
+        {
+            if (v == 0.0)
+                return;
+
+            for (std::size_t e = byColumns.start[j]; e < byColumns.start[j + 1]; e++)
+            {
+                if (row[byColumns.index[e]])
+                    b[byColumns.index[e]] -= byColumns.value[e] * v;
+            }
+            c0 += c[j] * v;
+            shift[j] += v;
+            upper[j] -= v;
+        }
+
+        void reduce(const SparseMatrix &A, int objective)
+        {
+            unsigned int m = A.rows();
+            bool changed = true;
+            for (unsigned int pass = 0; changed && pass < MAX_PASSES; pass++)
+            {
+                changed = false;
+
+                for (unsigned int i = 0; i < m; i++)
+                {
+                    if (!row[i])
+                        continue;
+
+                    unsigned int count = 0, last = 0;
+                    bool negative = false, positive = false;
+                    double most = 0.0, a = 0.0;   // sum a_ij u_j over a_ij > 0
+                    for (std::size_t e = A.start[i]; e < A.start[i + 1]; e++)
+                    {
+                        unsigned int j = A.index[e];
+                        if (!column[j])
+                            continue;
+
+                        count++;
+                        last = j;
+                        a = A.value[e];
+                        if (a < 0.0)
+                            negative = true;
+                        else
+                        {
+                            positive = true;
+                            most += a * upper[j];
+                        }
+                    }
+
+                    if (!negative && b[i] < -TOLERANCE)
+                    {
+                        report.status = INFEASIBLE;
+                        return;
+                    }
+
+                    if (count == 1 && a > 0.0)
+                    {
+                        upper[last] = std::min(upper[last], b[i] / a);
+                        report.bounds++;
+                    }
+                    else if (count == 1 && b[i] < 0.0)
+                    {
+                        move(last, b[i] / a);
+                        report.bounds++;
+                    }
+                    else if (!positive && b[i] >= 0.0)
+                    {
+                        report.redundant++;
+                    }
+                    else if (!negative && most <= b[i])
+                    {
+                        report.redundant++;
+                    }
+                    else if (!negative && b[i] <= TOLERANCE)
+                    {
+                        // all of them at 0
+                        for (std::size_t e = A.start[i]; e < A.start[i + 1]; e++)
+                        {
+                            if (column[A.index[e]])
+                                upper[A.index[e]] = 0.0;
+                        }
+                        report.redundant++;
+                    }
+                    else
+                    {
+                        continue;
+                    }
+
+                    row[i] = false;
+                    changed = true;
+                }
+
+                for (unsigned int j = 0; j < n; j++)
+                {
+                    if (!column[j])
+                        continue;
+
+                    if (upper[j] < -TOLERANCE)
+                    {
+                        report.status = INFEASIBLE;
+                        return;
+                    }
+
+                    bool negative = false, positive = false;
+                    for (std::size_t e = byColumns.start[j]; e < byColumns.start[j + 1]; e++)
+                    {
+                        if (!row[byColumns.index[e]])
+                            continue;
+                        if (byColumns.value[e] < 0.0)
+                            negative = true;
+                        else
+                            positive = true;
+                    }
+
+                    double gain = objective * c[j];
+                    if (upper[j] <= TOLERANCE || (!negative && gain <= 0.0))
+                    {
+                        fix(j, 0.0);
+                    }
+                    else if (!positive && gain > 0.0)
+                    {
+                        if (upper[j] == HUGE_VAL)
+                        {
+                            report.status = UNBOUNDED;
+                            return;
+                        }
+                        fix(j, upper[j]);
+                    }
+                    else
+                    {
+                        continue;
+                    }
+
+                    changed = true;
+                }
+            }
+        }
+
+        // The rows and columns left, and one row per upper bound that no
+        // row left implies (one with no negative entry: b_i / a_ij <= u_j)
+        void rebuild(std::vector<double> &variables, SparseMatrix &A)
+        {
+            unsigned int m = A.rows();
+
+            index.assign(n, NONE);
+            variables.clear();
+            for (unsigned int j = 0; j < n; j++)
+            {
+                if (!column[j])
+                    continue;
+
+                index[j] = (unsigned int)variables.size();
+                variables.push_back(c[j]);
+            }
+            variables.push_back(c0);
+
+            std::vector<double> implied(n, HUGE_VAL);
+            SparseMatrix presolved;
+            std::vector<SparseMatrix::Entry> entries;
+            for (unsigned int i = 0; i < m; i++)
+            {
+                if (!row[i])
+                    continue;
+
+                bool negative = false;
+                entries.clear();
+                for (std::size_t e = A.start[i]; e < A.start[i + 1]; e++)
+                {
+                    unsigned int j = A.index[e];
+                    if (!column[j])
+                        continue;
+
+                    entries.push_back(SparseMatrix::Entry(index[j], A.value[e]));
+                    negative = negative || A.value[e] < 0.0;
+                }
+                presolved.addRow(entries, b[i]);
+
+                for (std::size_t e = A.start[i]; e < A.start[i + 1] && !negative; e++)
+                {
+                    unsigned int j = A.index[e];
+                    if (column[j])
+                        implied[j] = std::min(implied[j], b[i] / A.value[e]);
+                }
+            }
+
+            for (unsigned int j = 0; j < n; j++)
+            {
+                if (column[j] && upper[j] < implied[j])
+                {
+                    entries.assign(1, SparseMatrix::Entry(index[j], 1.0));
+                    presolved.addRow(entries, upper[j]);
+                }
+            }
+
+            A = presolved;
+        }
+
+        // Geometric mean scaling, by powers of 2: a_ij r_i s_j, b_i r_i, c_j s_j
+        void scale(std::vector<double> &variables, SparseMatrix &A)
+        {
+            unsigned int
+                m = A.rows(),
+                cols = (unsigned int)variables.size() - 1;
+
+            std::vector<double> r(m, 1.0), low, high;
+            scaling.assign(cols, 1.0);
+            for (unsigned int pass = 0; pass < SCALE_PASSES; pass++)
+            {
+                for (unsigned int i = 0; i < m; i++)
+                {
+                    double lo = HUGE_VAL, hi = 0.0;
+                    for (std::size_t e = A.start[i]; e < A.start[i + 1]; e++)
+                    {
+                        double a = fabs(A.value[e] * scaling[A.index[e]]);
+                        lo = std::min(lo, a);
+                        hi = std::max(hi, a);
+                    }
+                    if (hi > 0.0)
+                        r[i] = nearestPowerOf2(1.0 / sqrt(lo * hi));
+                }
+
+                low.assign(cols, HUGE_VAL);
+                high.assign(cols, 0.0);
+                for (unsigned int i = 0; i < m; i++)
+                {
+                    for (std::size_t e = A.start[i]; e < A.start[i + 1]; e++)
+                    {
+                        double a = fabs(A.value[e] * r[i]);
+                        low[A.index[e]] = std::min(low[A.index[e]], a);
+                        high[A.index[e]] = std::max(high[A.index[e]], a);
+                    }
+                }
+                for (unsigned int j = 0; j < cols; j++)
+                {
+                    if (high[j] > 0.0)
+                        scaling[j] = nearestPowerOf2(1.0 / sqrt(low[j] * high[j]));
+                }
+            }
+
+            for (unsigned int i = 0; i < m; i++)
+            {
+                for (std::size_t e = A.start[i]; e < A.start[i + 1]; e++)
+                    A.value[e] *= r[i] * scaling[A.index[e]];
+                A.rhs[i] *= r[i];
+            }
+            for (unsigned int j = 0; j < cols; j++)
+                variables[j] *= scaling[j];
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef SIMPLEX_PRICING_H
+#define SIMPLEX_PRICING_H
+
+#include <vector>
+#include <algorithm>
+
+namespace simplex
+{
+    // Rules to pick the entering column, shared by both engines.
+    //
+    // DANTZIG takes the largest reduced cost. PARTIAL does the same within
+    // one segment of the columns at a time (the first one, from where the
+    // last search stopped, that has a candidate). DEVEX and STEEPEST_EDGE
+    // take the largest d_j^2 / w_j, where w_j approximates (Devex) or is
+    // (steepest edge) 1 + |B^-1 a_j|^2, the squared length of the edge the
+    // column would move along; they usually need far fewer iterations.
+    //
+    // Whatever the rule, after DEGENERATE_LIMIT degenerate pivots in a row
+    // (the objective did not move) Bland's rule takes over until the next
+    // pivot that makes progress: the improving column of the lowest
+    // variable, and on a tie in the ratio test the row of the lowest
+    // variable. Bland's rule cannot cycle.
+    namespace pricing
+    {
+        enum Rule
+        {
+            DANTZIG,
+            PARTIAL,
+            DEVEX,
+            STEEPEST_EDGE
+        };
+
+        enum
+        {
+            DEGENERATE_LIMIT = 8,
+            PARTIAL_SEGMENTS = 8,   // the columns are split in this many segments...
+            PARTIAL_MIN = 64        // ... of at least this many columns
+        };
+
+        // Devex weights start again from 1 once one grows past this
+        const double DEVEX_RESET = 1e6;
+
+        inline const char* name(Rule r)
+        {
+            switch (r)
+            {
+            case DANTZIG: return "dantzig";
+            case PARTIAL: return "partial";
+            case DEVEX: return "devex";
+            default: return "steepest edge";
+            }
+        }
+
+        // Columns per segment for PARTIAL, out of {n}
+        inline unsigned int segmentSize(unsigned int n)
+        {
+            return std::max((unsigned int)PARTIAL_MIN, (n + PARTIAL_SEGMENTS - 1) / PARTIAL_SEGMENTS);
+        }
+
+        // How the candidate (reduced cost {d} > 0, weight {w}) ranks under {r}
+        inline double score(Rule r, double d, double w)
+        {
+            return r == DEVEX || r == STEEPEST_EDGE ? d * d / w : d;
+        }
+
+        // Devex update of the weight of a nonbasic column with pivot row
+        // entry {ratio} = alpha_rj / alpha_rq, {wq} the weight of the
+        // entering column (Forrest and Goldfarb)
+        inline double devex(double w, double ratio, double wq)
+        {
+            return std::max(w, ratio * ratio * wq);
+        }
+
+        // Steepest edge update of the same (Goldfarb and Reid); {tau} is
+        // a_j^T B^-T alpha_q and {wq} the exact 1 + |alpha_q|^2
+        inline double steepestEdge(double w, double ratio, double tau, double wq)
+        {
+            return std::max(w - 2.0 * ratio * tau + ratio * ratio * wq, 1.0 + ratio * ratio);
+        }
+
+        // Weight of the leaving variable, {pivot} = alpha_rq
+        inline double leaving(double wq, double pivot)
+        {
+            return std::max(wq / (pivot * pivot), 1.0);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,755 @@
+#ifndef SIMPLEX_REVISED_H
+#define SIMPLEX_REVISED_H
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <math.h>
+
+#include "tableau.h"
+#include "sparse.h"
+#include "kernel.h"
+#include "pricing.h"
+
+namespace simplex
+{
+    // Values closer to zero than this count as zero (reduced costs, pivot
+    // column entries, infeasibilities)
+    const double TOLERANCE = 1e-9;
+
+    // Revised simplex engine for: maximize c x s.t. A x + s = b, x, s >= 0.
+    //
+    // Instead of the whole tableau it keeps the constraint matrix, by rows
+    // and by columns (CSC), and an LU factorization of the basis B (the m
+    // columns of [A I] of the basic variables), and derives what an
+    // iteration needs from it:
+    //
+    //   BTRAN  y = c_B B^-1      the prices, for the reduced costs c - y A
+    //   FTRAN  a = B^-1 A_q      the entering column, for the ratio test
+    //
+    // Each solve costs O(m^2), and pricing streams once over the rows of A
+    // with a non-zero price: the sparse ones (CSR) entry by entry, those at
+    // least 1 / DENSE_FRACTION full as plain rows with the pivot kernel.
+    // After a pivot the factorization is updated in place (Forrest-Tomlin):
+    // the column of U of the leaving variable is replaced by the entering
+    // one and moved last, and the row left below the diagonal is eliminated
+    // with row operations that are kept as etas. Every REFACTOR_EVERY
+    // updates, or when an update is unstable, B is factorized again.
+    //
+    // Variables are numbered as in the tableau: the n structural ones first,
+    // then one slack per constraint. The pivot rules are the tableau's (see
+    // pricing.h), so both engines follow the same path (in exact arithmetic)
+    // and dictionary() rebuilds the tableau they would show. With the
+    // PARTIAL rule only the reduced costs of the segments searched are
+    // computed, column by column; DEVEX and STEEPEST_EDGE update their
+    // weights from the pivot row, which costs one more BTRAN and pass over
+    // A per pivot (two for STEEPEST_EDGE).
+    class Revised
+    {
+    public:
+        enum
+        {
+            REFACTOR_EVERY = 64,    // updates between two factorizations
+            DENSE_FRACTION = 4      // rows with at least n / 4 non-zeros are kept dense
+        };
+
+        unsigned int
+            refactorizations,
+            updates;    // Forrest-Tomlin updates since the last factorization
+
+        // {variables} are the objective coefficients followed by its constant,
+        // as in Problem
+        Revised(const std::vector<double> &variables, const SparseMatrix &constraints, double objective, kernel::Kernel _k = kernel::BEST, pricing::Rule _rule = pricing::DANTZIG) :
+            refactorizations(0),
+            updates(0),
+            m(constraints.rows()),
+            n((unsigned int)variables.size() - 1),
+            k(_k == kernel::BEST || !kernel::supported(_k) ? kernel::best() : _k),
+            rule(_rule),
+            segment(0),
+            b(constraints.rhs),
+            priced(false),
+            complete(false),
+            singular(false)
+        {
+            constraints.transpose(A, n);
+
+            // split the rows: dense ones into D, the rest into R
+            unsigned int count = 0;
+            dense.assign(m, NONE);
+            for (unsigned int i = 0; i < m; i++)
+            {
+                if ((constraints.start[i + 1] - constraints.start[i]) * DENSE_FRACTION >= n)
+                    dense[i] = count++;
+            }
+
+            D.resize(count, n);
+            std::vector<SparseMatrix::Entry> entries;
+            for (unsigned int i = 0; i < m; i++)
+            {
+                entries.clear();
+                for (std::size_t e = constraints.start[i]; e < constraints.start[i + 1]; e++)
+                {
+                    if (dense[i] != NONE)
+                        D[dense[i]][constraints.index[e]] = constraints.value[e];
+                    else
+                        entries.push_back(SparseMatrix::Entry(constraints.index[e], constraints.value[e]));
+                }
+                R.addRow(entries, 0.0);
+            }
+
+            c.assign(n + m, 0.0);
+            for (unsigned int j = 0; j < n; j++)
+                c[j] = variables[j] * objective;
+            constant = variables[n] * objective;
+
+            basis.resize(m);
+            for (unsigned int i = 0; i < m; i++)
+                basis[i] = n + i;
+            nonbasic.resize(n);
+            for (unsigned int j = 0; j < n; j++)
+                nonbasic[j] = j;
+
+            d.resize(1, n);
+            work.resize(1, n);
+            y.resize(m);
+            alpha.resize(m);
+            spike.resize(m);
+
+            refactor();
+            setPricing(rule);
+        };
+
+        unsigned int countRows() const { return m; }
+        unsigned int countColumns() const { return n; }
+        double objectiveValue() const { return value; }
+
+        // value of the basic variable of {row}
+        double basicValue(unsigned int row) const { return x[row]; }
+
+        // Starts the weights of the rule again from the current basis
+        void setPricing(pricing::Rule _rule)
+        {
+            rule = _rule;
+            segment = 0;
+            weights.assign(n + m, 1.0);
+            if (rule != pricing::STEEPEST_EDGE)
+                return;
+
+            // with only slacks in the basis, B^-1 a_j is a_j reordered
+            bool slacks = true;
+            for (unsigned int i = 0; i < m; i++)
+                slacks = slacks && basis[i] >= n;
+
+            std::vector<double> column(m), w(m);
+            for (unsigned int j = 0; j < n; j++)
+            {
+                unsigned int v = nonbasic[j];
+                double norm = 1.0;
+                if (slacks)
+                {
+                    for (std::size_t e = A.start[v]; e < A.start[v + 1]; e++)
+                        norm += A.value[e] * A.value[e];
+                }
+                else
+                {
+                    ftran(j, column, w);
+                    for (unsigned int i = 0; i < m; i++)
+                        norm += column[i] * column[i];
+                }
+                weights[v] = norm;
+            }
+        }
+
+        // The column the rule picks (on a tie, the first one), or with
+        // {bland} the improving column of the lowest variable. Returns false
+        // if no column improves the objective.
+        bool price(unsigned int &column, bool bland = false)
+        {
+            if (rule == pricing::PARTIAL && !bland)
+                return pricePartial(column);
+
+            prices(true);
+
+            double best = 0.0;
+            bool found = false;
+            for (unsigned int j = 0; j < n; j++)
+            {
+                unsigned int v = nonbasic[j];
+                double r = reducedCost(v);
+                if (!(r > TOLERANCE))
+                    continue;
+
+                if (bland)
+                {
+                    if (!found || v < nonbasic[column])
+                        column = j;
+                    found = true;
+                    continue;
+                }
+
+                double score = pricing::score(rule, r, weights[v]);
+                if (score > best)
+                {
+                    best = score;
+                    column = j;
+                    found = true;
+                }
+            }
+            return found;
+        }
+
+        // Ratio test for the variable at {column}: the first row with the
+        // smallest x_i / a_i over a_i > 0, or with {bland} the one of the
+        // lowest variable. Returns false if the objective is unbounded
+        // along that column.
+        bool ratio(unsigned int column, unsigned int &row, bool bland = false)
+        {
+            ftran(column, alpha, spike);
+
+            double best = HUGE_VAL;
+            unsigned int leaving = m;
+            for (unsigned int i = 0; i < m; i++)
+            {
+                if (!(alpha[i] > TOLERANCE))
+                    continue;
+
+                double V = fabs(x[i] / alpha[i]);
+                if (V < best || (bland && V == best && basis[i] < basis[leaving]))
+                {
+                    best = V;
+                    leaving = i;
+                }
+            }
+
+            if (leaving == m)
+                return false;
+            row = leaving;
+            return true;
+        }
+
+        // Exchanges the basic variable of {row} with the variable at
+        // {column}, after ratio() on that column. Returns false if the new
+        // basis turned out singular.
+        bool pivot(unsigned int row, unsigned int column)
+        {
+            unsigned int q = nonbasic[column];
+            double theta = x[row] / alpha[row];
+
+            if (rule == pricing::DEVEX || rule == pricing::STEEPEST_EDGE)
+                updateWeights(row, column);
+
+            prices(false);
+            value += theta * reducedCost(q);
+            for (unsigned int i = 0; i < m; i++)
+                x[i] -= theta * alpha[i];
+            x[row] = theta;
+
+            nonbasic[column] = basis[row];
+            basis[row] = q;
+            priced = complete = false;
+
+            if (updates >= REFACTOR_EVERY || !forrestTomlin(row))
+                refactor();
+            return !singular;
+        }
+
+        bool isFeasible()
+        {
+            if (singular)
+                return false;
+            for (unsigned int i = 0; i < m; i++)
+            {
+                if (x[i] < -TOLERANCE)
+                    return false;
+            }
+            return true;
+        }
+
+        // Does any column improve the objective? With PARTIAL the search
+        // starts at the next segment and stops at the first one found.
+        bool isOptimal()
+        {
+            bool partial = rule == pricing::PARTIAL;
+            prices(!partial);
+
+            unsigned int first = partial ? segment * pricing::segmentSize(n) : 0;
+            for (unsigned int j = 0; j < n; j++)
+            {
+                if (reducedCost(nonbasic[(first + j) % n]) > TOLERANCE)
+                    return false;
+            }
+            return true;
+        }
+
+        // The tableau of the current basis, laid out as in Problem: labels in
+        // row and column 0, the objective in row 1 and the right hand sides
+        // in column 1. Without {full} only the labels, the right hand sides
+        // and the objective value are filled in (no solves needed).
+        void dictionary(Tableau &T, bool full)
+        {
+            T.resize(m + 2, n + 2);
+
+            T[1][1] = value;
+            for (unsigned int j = 0; j < n; j++)
+                T[0][j + 2] = nonbasic[j] + 1;
+            for (unsigned int i = 0; i < m; i++)
+            {
+                T[i + 2][0] = basis[i] + 1;
+                T[i + 2][1] = x[i];
+            }
+
+            if (!full)
+                return;
+
+            prices(true);
+            std::vector<double> column(m), w(m);
+            for (unsigned int j = 0; j < n; j++)
+            {
+                T[1][j + 2] = reducedCost(nonbasic[j]);
+
+                ftran(j, column, w);
+                for (unsigned int i = 0; i < m; i++)
+                    T[i + 2][j + 2] = -column[i];
+            }
+        }
+
+    private:
+        enum
+        {
+            NONE = 0xFFFFFFFF
+        };
+
+        unsigned int
+            m,          // constraints
+            n;          // structural variables
+        kernel::Kernel
+            k;
+        pricing::Rule
+            rule;
+        unsigned int
+            segment;    // where PARTIAL searches next
+        SparseMatrix
+            R,          // the sparse rows of the constraint matrix (dense ones left empty)
+            A;          // the constraint matrix, transposed: row j is column j
+        Tableau
+            D,          // the dense rows
+            d,          // reduced costs of the structural variables (1 x n)
+            work;       // a row of products with A (1 x n)
+        std::vector<unsigned int>
+            dense;      // row of D of each constraint, or NONE
+        std::vector<double>
+            b,
+            c,          // costs of all the variables, slacks are 0
+            x,          // value of the basic variable of each row
+            y,          // prices
+            alpha,      // B^-1 A_q of the last ratio()
+            spike,      // the same before the U solve, for the update
+            weights;    // DEVEX / STEEPEST_EDGE weight of each variable
+        double
+            constant,
+            value;      // of the objective
+        std::vector<unsigned int>
+            basis,      // variable of each row
+            nonbasic;   // variable of each column
+        bool
+            priced,     // y is up to date
+            complete,   // and so is d
+            singular;
+
+        // Factorization: F B = U, with F = E_t .. E_1 P L^-1.
+        //
+        // L^-1 is a sequence of column etas, one per elimination step s: the
+        // pivot row l_row[s] of the constraint matrix is subtracted from the
+        // rows l_index[..] times l_value[..]. P moves row l_row[s] to position
+        // l_col[s], the basis position eliminated at step s. E are the row
+        // etas of the updates: row e_row[..] -= e_value[..] * row e_col[..].
+        //
+        // U (m x m, row major) is upper triangular in the order given by
+        // {order}: row and column p meet on the diagonal, and U[p][q] is 0
+        // whenever q comes before p in {order}.
+        std::vector<unsigned int>
+            l_row,
+            l_col,
+            l_index,
+            e_row,
+            e_col,
+            order,
+            where;      // position of each row / column in {order}
+        std::vector<std::size_t>
+            l_start;
+        std::vector<double>
+            l_value,
+            e_value,
+            U;
+
+        // c_v - y a_v, from d when it is complete
+        double reducedCost(unsigned int v)
+        {
+            if (v >= n)
+                return -y[v - n];
+            if (complete)
+                return d[0][v];
+
+            double r = c[v];
+            for (std::size_t e = A.start[v]; e < A.start[v + 1]; e++)
+                r -= y[A.index[e]] * A.value[e];
+            return r;
+        }
+
+        // y = c_B B^-1, and with {all} d = c - y A
+        void prices(bool all)
+        {
+            if (!priced)
+            {
+                std::vector<double> cB(m);
+                for (unsigned int i = 0; i < m; i++)
+                    cB[i] = c[basis[i]];
+                btran(cB, y);
+
+                priced = true;
+                complete = false;
+            }
+
+            if (!all || complete)
+                return;
+
+            double *row = d[0];
+            for (unsigned int j = 0; j < n; j++)
+                row[j] = c[j];
+            subtract(y, row);
+            complete = true;
+        }
+
+        // row -= u A, skipping the rows of A where u is 0
+        void subtract(const std::vector<double> &u, double *row)
+        {
+            for (unsigned int i = 0; i < m; i++)
+            {
+                if (u[i] == 0.0)
+                    continue;
+
+                if (dense[i] != NONE)
+                {
+                    kernel::update(k, row, D[dense[i]], u[i], d.stride());
+                    continue;
+                }
+                for (std::size_t e = R.start[i]; e < R.start[i + 1]; e++)
+                    row[R.index[e]] -= u[i] * R.value[e];
+            }
+        }
+
+        // Dantzig over the first segment, from {segment} on, with a
+        // candidate; the next search starts at the segment after it
+        bool pricePartial(unsigned int &column)
+        {
+            prices(false);
+
+            unsigned int size = pricing::segmentSize(n);
+            unsigned int segments = (n + size - 1) / size;
+            for (unsigned int s = 0; s < segments; s++)
+            {
+                unsigned int current = (segment + s) % segments;
+                unsigned int last = std::min(n, (current + 1) * size);
+
+                double best = TOLERANCE;
+                bool found = false;
+                for (unsigned int j = current * size; j < last; j++)
+                {
+                    double r = reducedCost(nonbasic[j]);
+                    if (r > best)
+                    {
+                        best = r;
+                        column = j;
+                        found = true;
+                    }
+                }
+
+                if (found)
+                {
+                    segment = (current + 1) % segments;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Updates the weights for the pivot on {row} and the variable at
+        // {column}, from the pivot row alpha_r = e_r B^-1 [A I]
+        void updateWeights(unsigned int row, unsigned int column)
+        {
+            unsigned int q = nonbasic[column];
+            double pivot = alpha[row];
+
+            std::vector<double> unit(m, 0.0), rho(m), v(m);
+            unit[row] = 1.0;
+            btran(unit, rho);
+
+            // work = -rho A, d is only needed again after the pivot
+            double *ar = work[0];
+            std::fill(ar, ar + n, 0.0);
+            subtract(rho, ar);
+
+            // STEEPEST_EDGE also needs a_j B^-T alpha_q, in d
+            double wq = weights[q];
+            double *tau = d[0];
+            if (rule == pricing::STEEPEST_EDGE)
+            {
+                wq = 1.0;
+                for (unsigned int i = 0; i < m; i++)
+                    wq += alpha[i] * alpha[i];
+
+                btran(alpha, v);
+                std::fill(tau, tau + n, 0.0);
+                subtract(v, tau);
+                complete = false;
+            }
+
+            bool reset = false;
+            for (unsigned int j = 0; j < n; j++)
+            {
+                unsigned int var = nonbasic[j];
+                double a = var < n ? -ar[var] : rho[var - n];
+                if (j == column || a == 0.0)
+                    continue;
+
+                double ratio = a / pivot;
+                if (rule == pricing::DEVEX)
+                {
+                    weights[var] = pricing::devex(weights[var], ratio, wq);
+                    reset = reset || weights[var] > pricing::DEVEX_RESET;
+                }
+                else
+                {
+                    double t = var < n ? -tau[var] : v[var - n];
+                    weights[var] = pricing::steepestEdge(weights[var], ratio, t, wq);
+                }
+            }
+            weights[basis[row]] = pricing::leaving(wq, pivot);
+
+            if (reset)
+                weights.assign(n + m, 1.0);
+        }
+
+        // out = B^-1 A_q for the variable at {column}; w gets F A_q
+        void ftran(unsigned int column, std::vector<double> &out, std::vector<double> &w)
+        {
+            unsigned int q = nonbasic[column];
+            std::vector<double> v(m, 0.0);
+            if (q < n)
+            {
+                for (std::size_t e = A.start[q]; e < A.start[q + 1]; e++)
+                    v[A.index[e]] = A.value[e];
+            }
+            else
+            {
+                v[q - n] = 1.0;
+            }
+            solve(v, out, w);
+        }
+
+        // out = B^-1 v (v is destroyed); w gets F v
+        void solve(std::vector<double> &v, std::vector<double> &out, std::vector<double> &w)
+        {
+            for (unsigned int s = 0; s < l_row.size(); s++)
+            {
+                double p = v[l_row[s]];
+                if (p == 0.0)
+                    continue;
+                for (std::size_t e = l_start[s]; e < l_start[s + 1]; e++)
+                    v[l_index[e]] -= l_value[e] * p;
+            }
+
+            for (unsigned int s = 0; s < l_row.size(); s++)
+                w[l_col[s]] = v[l_row[s]];
+
+            for (unsigned int e = 0; e < e_row.size(); e++)
+                w[e_row[e]] -= e_value[e] * w[e_col[e]];
+
+            for (unsigned int l = m; l-- > 0; )
+            {
+                unsigned int p = order[l];
+                const double *u = &U[(std::size_t)p * m];
+                double sum = w[p];
+                for (unsigned int r = l + 1; r < m; r++)
+                    sum -= u[order[r]] * out[order[r]];
+                out[p] = sum / u[p];
+            }
+        }
+
+        // out^T = v^T B^-1
+        void btran(const std::vector<double> &v, std::vector<double> &out)
+        {
+            std::vector<double> s(v), z(m);
+            for (unsigned int l = 0; l < m; l++)
+            {
+                unsigned int p = order[l];
+                const double *u = &U[(std::size_t)p * m];
+                z[p] = s[p] / u[p];
+                if (z[p] == 0.0)
+                    continue;
+                for (unsigned int r = l + 1; r < m; r++)
+                    s[order[r]] -= z[p] * u[order[r]];
+            }
+
+            for (unsigned int e = (unsigned int)e_row.size(); e-- > 0; )
+                z[e_col[e]] -= e_value[e] * z[e_row[e]];
+
+            for (unsigned int s = 0; s < l_row.size(); s++)
+                out[l_row[s]] = z[l_col[s]];
+
+            for (unsigned int s = (unsigned int)l_row.size(); s-- > 0; )
+            {
+                double sum = 0.0;
+                for (std::size_t e = l_start[s]; e < l_start[s + 1]; e++)
+                    sum += l_value[e] * out[l_index[e]];
+                out[l_row[s]] -= sum;
+            }
+        }
+
+        // Replaces column {row} of U by the spike of the entering column
+        bool forrestTomlin(unsigned int row)
+        {
+            unsigned int r = row;
+            for (unsigned int p = 0; p < m; p++)
+                U[(std::size_t)p * m + r] = spike[p];
+
+            // move r last
+            unsigned int from = where[r];
+            for (unsigned int l = from; l + 1 < m; l++)
+            {
+                order[l] = order[l + 1];
+                where[order[l]] = l;
+            }
+            order[m - 1] = r;
+            where[r] = m - 1;
+
+            // eliminate what row r now has left of the diagonal
+            double *ur = &U[(std::size_t)r * m];
+            for (unsigned int l = from; l + 1 < m; l++)
+            {
+                unsigned int p = order[l];
+                if (ur[p] == 0.0)
+                    continue;
+
+                const double *up = &U[(std::size_t)p * m];
+                double mu = ur[p] / up[p];
+                for (unsigned int t = l + 1; t < m; t++)
+                    ur[order[t]] -= mu * up[order[t]];
+                ur[p] = 0.0;
+
+                e_row.push_back(r);
+                e_col.push_back(p);
+                e_value.push_back(mu);
+            }
+
+            updates++;
+            return fabs(ur[r]) > 1e-11;
+        }
+
+        // LU factorization of the current basis with partial pivoting, the
+        // slack columns first (they are trivially triangular), then the
+        // basic values are computed again from scratch
+        void refactor()
+        {
+            refactorizations++;
+            updates = 0;
+            priced = complete = false;
+
+            l_row.clear();
+            l_col.clear();
+            l_index.clear();
+            l_value.clear();
+            l_start.assign(1, 0);
+            e_row.clear();
+            e_col.clear();
+            e_value.clear();
+
+            std::vector<double> W((std::size_t)m * m, 0.0);
+            std::vector<unsigned int> columns;
+            for (unsigned int j = 0; j < m; j++)
+            {
+                unsigned int v = basis[j];
+                if (v >= n)
+                {
+                    W[(std::size_t)(v - n) * m + j] = 1.0;
+                    columns.push_back(j);
+                }
+            }
+            for (unsigned int j = 0; j < m; j++)
+            {
+                unsigned int v = basis[j];
+                if (v < n)
+                {
+                    for (std::size_t e = A.start[v]; e < A.start[v + 1]; e++)
+                        W[(std::size_t)A.index[e] * m + j] = A.value[e];
+                    columns.push_back(j);
+                }
+            }
+
+            U.assign((std::size_t)m * m, 0.0);
+            std::vector<char> done(m, 0);
+            for (unsigned int s = 0; s < m; s++)
+            {
+                unsigned int j = columns[s];
+
+                unsigned int pivot = m;
+                double best = 1e-12;
+                for (unsigned int i = 0; i < m; i++)
+                {
+                    if (!done[i] && fabs(W[(std::size_t)i * m + j]) > best)
+                    {
+                        best = fabs(W[(std::size_t)i * m + j]);
+                        pivot = i;
+                    }
+                }
+                if (pivot == m)
+                {
+                    singular = true;
+                    return;
+                }
+
+                done[pivot] = 1;
+                const double *wp = &W[(std::size_t)pivot * m];
+                double *u = &U[(std::size_t)j * m];
+                u[j] = wp[j];
+                for (unsigned int t = s + 1; t < m; t++)
+                    u[columns[t]] = wp[columns[t]];
+
+                for (unsigned int i = 0; i < m; i++)
+                {
+                    double *wi = &W[(std::size_t)i * m];
+                    if (done[i] || wi[j] == 0.0)
+                        continue;
+
+                    double mu = wi[j] / wp[j];
+                    for (unsigned int t = s + 1; t < m; t++)
+                        wi[columns[t]] -= mu * wp[columns[t]];
+                    wi[j] = 0.0;
+
+                    l_index.push_back(i);
+                    l_value.push_back(mu);
+                }
+
+                l_row.push_back(pivot);
+                l_col.push_back(j);
+                l_start.push_back(l_index.size());
+            }
+
+            order = columns;
+            where.resize(m);
+            for (unsigned int l = 0; l < m; l++)
+                where[order[l]] = l;
+
+            std::vector<double> v(b), w(m);
+            x.resize(m);
+            solve(v, x, w);
+
+            value = constant;
+            for (unsigned int i = 0; i < m; i++)
+                value += c[basis[i]] * x[i];
+        }
+    };
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include <iostream>
+#include <cstdlib>
 #include "simplex-tools.h"
+#include "branch.h"
 
 using namespace tools;
 using namespace simplex;
@@ -22,6 +24,15 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    // "presolve" after the input file shrinks and scales the problem
+    // before it is solved (see presolve.h)
+    int arg = 2;
+    if (argc > arg && tools::iequals(argv[arg], "presolve"))
+    {
+        problem.presolve().print(cout);
+        arg++;
+    }
+
     problem.print();
     tools::wait();
 
@@ -41,6 +52,28 @@ int main(int argc, char *argv[])
     // ... until the solution is optimal [hint: problem.isOptimal == true]
     // end
 
+    // Threads, revised method, pricing, batches, warm start and presolve: see
+    // parallel.h, revised.h, pricing.h, batch.h, simplex-tools.h and presolve.h
+
+    // Integer variables (the [INTEGER] section): branch and bound, on every
+    // core, stops within the relative gap or after the node limit given
+    // after the input file and "presolve" (0: none)
+    if (!problem.integers.empty())
+    {
+        BranchAndBound search;
+        search.threads = 0;
+        search.gap = argc > arg ? atof(argv[arg]) : 0.0;
+        search.nodeLimit = argc > arg + 1 ? atol(argv[arg + 1]) : 0;
+        search.Solve(problem);
+        search.report(cout);
+
+        cout << "The results found:" << endl;
+        search.result();
+        tools::wait();
+
+        return 0;
+    }
+
     cout << "The results found:" << endl;
     problem.result();
     tools::wait();
@@ -5,27 +5,61 @@
 #include <vector>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <math.h>
 #include <cstdlib>
+#include <utility>
+#include <memory>
+#include "tableau.h"
+#include "kernel.h"
+#include "parallel.h"
+#include "pricing.h"
+#include "sparse.h"
+#include "revised.h"
+#include "presolve.h"
 #include "../common/io.h"
 #include "../common/string.h"
-
-#define CMAX  10  //max. number of variables in economic function
-#define VMAX  10  //max. number of constraints
+#include "../common/snapshot.h"
 
 using namespace tools;
 namespace simplex
 {
+    // A problem owns its tableau, so it is moved around rather than copied
     class Problem
     {
     private:
-        double
-            TS[CMAX][VMAX];
+        Tableau
+            TS;     // (NC + 2) x (NV + 2), row 0 and column 0 hold the variable labels
         unsigned int
             P1,
             P2;
+        std::unique_ptr<tools::ThreadPool>
+            pool;   // NULL when running on a single thread
+        std::unique_ptr<Revised>
+            revised;    // NULL with the tableau method
+        std::unique_ptr<Presolve>
+            presolved;  // NULL until presolve()
+        pricing::Rule
+            rule;
+        std::vector<double>
+            weights;    // DEVEX weight of each variable, by label
+        unsigned int
+            segment,    // where PARTIAL searches next
+            stalled;    // degenerate pivots in a row
+
+        // worth splitting the tableau across the pool?
+        bool isParallel()
+        {
+            return pool && pool->size() > 1 && (std::size_t)TS.rows() * TS.stride() >= parallel::MIN_ELEMENTS;
+        }
 
     public:
+        enum Method
+        {
+            TABLEAU,    // the whole tableau is updated on every pivot
+            REVISED     // only an LU factorization of the basis is kept
+        };
+
         enum Objective
         {
             MAXIMIZE =  1,
@@ -36,40 +70,112 @@ namespace simplex
         Objective
             objective;
 
+        kernel::Kernel
+            pivotKernel;    // vector code used by Formula()
+
         std::vector < double >
             variables;
 
-        std::vector < std::vector < double > >
-            constraints;
+        SparseMatrix
+            constraints;    // only the non-zeros, by rows
+
+        std::vector<unsigned int>
+            integers;       // variables (from 0) that only take integer values
 
         bool
             error, //XERR:       BOOLEAN IF TRUE, NO SOLUTION
             isOptimal; // NOPTIMAL
 
+        // Since Prepare() or setMethod()
+        struct Counters
+        {
+            unsigned long
+                iterations,     // calls to Pivot()
+                pivots,         // pivots made
+                degenerate,     // ... that left the objective as it was
+                bland;          // ... picked by Bland's rule
+
+            Counters() :
+                iterations(0),
+                pivots(0),
+                degenerate(0),
+                bland(0)
+            {};
+        };
+
+        Counters
+            counters;
+
         Problem() :
             P1(0),
             P2(0),
+            rule(pricing::DANTZIG),
+            segment(0),
+            stalled(0),
             objective(VOID),
+            pivotKernel(kernel::BEST),
             error(false),
             isOptimal(false)
         {};
 
+        Problem(Problem &&other) :
+            TS(std::move(other.TS)),
+            P1(other.P1),
+            P2(other.P2),
+            pool(std::move(other.pool)),
+            revised(std::move(other.revised)),
+            presolved(std::move(other.presolved)),
+            rule(other.rule),
+            weights(std::move(other.weights)),
+            segment(other.segment),
+            stalled(other.stalled),
+            objective(other.objective),
+            pivotKernel(other.pivotKernel),
+            variables(std::move(other.variables)),
+            constraints(std::move(other.constraints)),
+            integers(std::move(other.integers)),
+            error(other.error),
+            isOptimal(other.isOptimal),
+            counters(other.counters)
+        {};
+
+        Problem& operator=(Problem &&other)
+        {
+            TS = std::move(other.TS);
+            P1 = other.P1;
+            P2 = other.P2;
+            pool = std::move(other.pool);
+            revised = std::move(other.revised);
+            presolved = std::move(other.presolved);
+            rule = other.rule;
+            weights = std::move(other.weights);
+            segment = other.segment;
+            stalled = other.stalled;
+            objective = other.objective;
+            pivotKernel = other.pivotKernel;
+            variables = std::move(other.variables);
+            constraints = std::move(other.constraints);
+            integers = std::move(other.integers);
+            error = other.error;
+            isOptimal = other.isOptimal;
+            counters = other.counters;
+            return *this;
+        }
+
         void Prepare()
         {
             unsigned int
                 NC = NumberOfConstraints(),
                 NV = NumberOfVariables();
 
-            // right size?
-            for (unsigned int j = 0; j < constraints.size(); j++)
+            if (!isWellFormed())
             {
-                if (constraints[j].size() - 1 != NV)
-                {
-                    objective = VOID;
-                    return;
-                }
+                objective = VOID;
+                return;
             }
 
+            TS.resize(NC + 2, NV + 2);
+
             for (unsigned int J = 1; J <= NV; J++)
             {
                 double R2 = variables[J - 1];
@@ -77,14 +183,18 @@ namespace simplex
             }
             TS[1][1] = variables[NV] * objective;
 
+            // -A: the zeros left out of the sparse rows become -0.0, as the
+            // dense rows always gave
             for (unsigned int I = 1; I <= NC; I++)
             {
                 for (unsigned int J = 1; J <= NV; J++)
+                    TS[I + 1][J + 1] = -0.0;
+                for (std::size_t e = constraints.start[I - 1]; e < constraints.start[I]; e++)
                 {
-                    double R2 = constraints[I - 1][J - 1];
-                    TS[I + 1][J + 1] = -R2;
+                    double R2 = constraints.value[e];
+                    TS[I + 1][constraints.index[e] + 2] = -R2;
                 }
-                TS[I + 1][1] = constraints[I - 1][NV];
+                TS[I + 1][1] = constraints.rhs[I - 1];
             }
 
             for (unsigned int J = 1; J <= NV; J++)
@@ -92,42 +202,245 @@ namespace simplex
             for (unsigned int I = NV + 1; I <= NV + NC; I++)
                 TS[I - NV + 1][0] = I;
 
+            restart();
+
+        }
+
+        // Splits Pivot() and Formula() by rows across {threads} threads
+        // (0: one per hardware thread, 1: no extra threads). The threads are
+        // kept until the problem is destroyed or this is called again.
+        void setThreads(unsigned int threads)
+        {
+            if (threads == 1)
+                pool.reset();
+            else
+                pool.reset(new tools::ThreadPool(threads));
+        }
+
+        unsigned int countThreads() { return pool ? pool->size() : 1; }
+
+        // Chooses the engine behind Pivot(), Formula() and Optimize(), and
+        // starts again from the initial basis. Both engines make the same
+        // pivots; the revised one suits problems with many more variables
+        // than constraints, but runs on a single thread.
+        void setMethod(Method method)
+        {
+            P1 = P2 = 0;
+            error = isOptimal = false;
+
+            if (method == REVISED && objective != VOID)
+            {
+                revised.reset(new Revised(variables, constraints, objective, pivotKernel, rule));
+                Tableau().swap(TS);
+                restart();
+            }
+            else
+            {
+                revised.reset();
+                Prepare();
+            }
+        }
+
+        Method getMethod() { return revised ? REVISED : TABLEAU; }
+
+        // Shrinks and scales the variables and constraints (see presolve.h)
+        // and starts again from the initial basis of what is left, with the
+        // same method. From then on print(), addConstraint() and setRhs()
+        // are about the presolved problem, while result() and solution()
+        // report the variables of the original one. Only the first call
+        // presolves, and not a problem with integer variables.
+        const Presolve::Report& presolve()
+        {
+            if (!presolved)
+            {
+                presolved.reset(new Presolve());
+                if (objective != VOID && isWellFormed())
+                    presolved->apply(variables, constraints, objective, !integers.empty());
+                setMethod(getMethod());
+            }
+            return presolved->report;
+        }
+
+        // An explicit copy at the same basis, to go on from there in two
+        // directions (see branch.h). The copy is on the tableau method, on
+        // a single thread, and without what presolve() needs to report the
+        // original variables.
+        Problem copy()
+        {
+            Problem p;
+            if (revised)
+            {
+                revised->dictionary(p.TS, true);
+            }
+            else if (TS.rows())
+            {
+                p.TS.resize(TS.rows(), TS.cols());
+                std::copy(TS[0], TS[0] + (std::size_t)TS.rows() * TS.stride(), p.TS[0]);
+            }
+
+            p.P1 = P1;
+            p.P2 = P2;
+            p.rule = rule;
+            p.weights = weights;
+            p.segment = segment;
+            p.stalled = stalled;
+            p.objective = objective;
+            p.pivotKernel = pivotKernel;
+            p.variables = variables;
+            p.constraints = constraints;
+            p.integers = integers;
+            p.error = error;
+            p.isOptimal = isOptimal;
+            p.counters = counters;
+            return p;
+        }
+
+        // The value of every variable at the current basis: {x}[j - 1] for
+        // variable #j, of the original problem after presolve()
+        void solution(std::vector<double> &x)
+        {
+            std::vector<bool> basic;
+            if (revised)
+            {
+                Tableau T;
+                revised->dictionary(T, false);
+                values(T, x, basic);
+            }
+            else
+            {
+                values(TS, x, basic);
+            }
+
+            if (presolved && presolved->isApplied())
+            {
+                std::vector<double> presolvedValues;
+                presolvedValues.swap(x);
+                x.resize(presolved->NumberOfVariables());
+                for (unsigned int j = 0; j < x.size(); j++)
+                    x[j] = presolved->postsolve(j, presolvedValues);
+            }
+        }
+
+        // Picks the rule for the entering column (see pricing.h); the
+        // weights start again from the current basis
+        void setPricing(pricing::Rule _rule)
+        {
+            rule = _rule;
+            segment = 0;
+            weights.assign(NumberOfVariables() + NumberOfConstraints() + 1, 1.0);
+            if (revised)
+                revised->setPricing(rule);
+        }
+
+        pricing::Rule getPricing() { return rule; }
+
+        // the "Function" value of result()
+        double objectiveValue() { return revised ? revised->objectiveValue() : TS[1][1]; }
+
+        // Do the constraints have the right size for the variables?
+        bool isWellFormed() const
+        {
+            unsigned int NV = variables.size() - 1;
+            for (std::size_t i = 0; i < integers.size(); i++)
+            {
+                if (integers[i] >= NV)
+                    return false;
+            }
+            return !constraints.isRagged() && constraints.cols() <= NV && (!constraints.denseWidth() || constraints.denseWidth() == NV);
         }
 
         unsigned int NumberOfVariables() { return variables.size() -1; } // NV
-        unsigned int NumberOfConstraints() { return constraints.size(); } // NC
+        unsigned int NumberOfConstraints() { return constraints.rows(); } // NC
 
+        // Leaves P1 and P2 at 0 if the tableau is optimal, and sets error if
+        // the objective is unbounded
         void Pivot()
         {
-            double RAP, V, XMAX;
-            unsigned int
-                NC = NumberOfConstraints(),
-                NV = NumberOfVariables();
-            unsigned int I, J;
+            bool bland = stalled >= pricing::DEGENERATE_LIMIT;
+            counters.iterations++;
+            P1 = P2 = 0;
 
-            XMAX = 0.0;
-            for (J = 2; J <= NV + 1; J++)
+            if (revised)
             {
-                if (TS[1][J] > 0.0 && TS[1][J] > XMAX)
+                unsigned int column, row;
+                if (!revised->price(column, bland))
+                    return;
+
+                P2 = column + 2;
+                if (!revised->ratio(column, row, bland))
                 {
-                    XMAX = TS[1][J];
-                    P2 = J;
+                    error = true;   // unbounded
+                    return;
                 }
+                P1 = row + 2;
+                count(revised->basicValue(row), bland);
+                return;
             }
 
-            RAP = 999999.0;
-            for (I = 2; I <= NC + 1; I++)
+            double RAP, V;
+            unsigned int
+                NC = NumberOfConstraints();
+            unsigned int I;
+
+            // a negative right hand side (after addConstraint() or setRhs()):
+            // dual simplex, from a basis that is optimal but not feasible
+            P1 = dualLeaving(bland);
+            if (P1 != 0)
             {
-                if (TS[I][P2] >= 0.0)
-                    continue;
+                if (isDualFeasible())
+                    P2 = dualEntering(bland);
+                if (P2 == 0)
+                {
+                    P1 = 0;
+                    error = true;   // infeasible (or not a basis to start from)
+                    return;
+                }
+                count(TS[1][P2], bland);
 
-                V = fabs(TS[I][1] / TS[I][P2]);
-                if (V < RAP)
+                V = TS[0][P2];
+                TS[0][P2] = TS[P1][0];
+                TS[P1][0] = V;
+                return;
+            }
+
+            P2 = entering(bland);
+            if (P2 == 0)
+                return;
+
+            RAP = HUGE_VAL;
+            if (bland)
+            {
+                // the first smallest ratio, then the lowest label
+                for (I = 2; I <= NC + 1; I++)
                 {
-                    RAP = V;
-                    P1 = I;
+                    if (TS[I][P2] >= 0.0)
+                        continue;
+
+                    V = fabs(TS[I][1] / TS[I][P2]);
+                    if (V < RAP || (V == RAP && TS[I][0] < TS[P1][0]))
+                    {
+                        RAP = V;
+                        P1 = I;
+                    }
                 }
             }
+            else if (isParallel())
+            {
+                parallel::RatioTest job(TS, 2, NC + 2, P2, pool->size());
+                pool->run(job);
+                job.merge(RAP, P1);
+            }
+            else
+            {
+                parallel::ratioTest(TS, 2, NC + 2, P2, RAP, P1);
+            }
+
+            if (P1 == 0)
+            {
+                error = true;   // unbounded
+                return;
+            }
+            count(TS[P1][1], bland);
 
             V = TS[0][P2];
             TS[0][P2] = TS[P1][0];
@@ -143,23 +456,37 @@ namespace simplex
                 I,
                 J;
 
-            for (I = 1; I <= NC + 1; I++)
+            if (error || P1 < 2 || P2 < 2)
+                return;
+
+            if (revised)
             {
-                if (I != P1)
-                {
-                    for (J = 1; J <= NV + 1; J++)
-                    {
-                        if (J != P2)
-                            TS[I][J] -= TS[P1][J] * TS[I][P2] / TS[P1][P2];
-                    }
-                }
+                if (!revised->pivot(P1 - 2, P2 - 2))
+                    error = true;
+                return;
             }
 
+            if (rule == pricing::DEVEX)
+                devex();
+
+            // TS[I][J] -= TS[P1][J] * TS[I][P2] / TS[P1][P2], for I != P1, J != P2
+            if (isParallel())
+            {
+                parallel::Eliminate job(TS, NC + 2, P1, P2, pivotKernel);
+                pool->run(job);
+            }
+            else
+            {
+                kernel::eliminate(TS, NC + 2, P1, P2, pivotKernel);
+            }
+
+            // -1 / pivot: the pivot is negative in a primal pivot (where
+            // this used to be its absolute value) and positive in a dual one
             TS[P1][P2] = 1.0 / TS[P1][P2];
             for (J = 1; J <= NV + 1; J++)
             {
                 if (J != P2)
-                    TS[P1][J] *= fabs(TS[P1][P2]);
+                    TS[P1][J] *= -TS[P1][P2];
             }
 
             for (I = 1; I <= NC + 1; I++)
@@ -177,11 +504,30 @@ namespace simplex
                 NC = NumberOfConstraints(),
                 NV = NumberOfVariables();
 
-            for (I = 2; I <= NC + 1; I++)
-                if (TS[I][1] < 0.0)
+            if (revised)
+            {
+                if (!revised->isFeasible())
                     error = true;
 
+                isOptimal = true;
+                if (!error)
+                    isOptimal = revised->isOptimal();
+                return;
+            }
+
+            // rounding may leave a basic variable a little below 0
+            bool feasible = true;
+            for (I = 2; I <= NC + 1; I++)
+                if (TS[I][1] < -TOLERANCE)
+                    feasible = false;
+
+            // not feasible: dual simplex goes on while the basis stays
+            // optimal (dual feasible), there is no way back otherwise
             isOptimal = true;
+            if (!feasible && !error && isDualFeasible())
+                isOptimal = false;
+            if (!feasible && isOptimal)
+                error = true;
             if (error)
                 return;
 
@@ -190,7 +536,130 @@ namespace simplex
                     isOptimal = false;
         }
 
+        // Adds the constraint sum(a_j x_j) <= {rhs}, {entries} being the
+        // (j, a_j) with j from 0 (as in SparseMatrix::addRow()), to a
+        // prepared problem: the new row is written in terms of the current
+        // basis, so Pivot(), Formula() and Optimize() go on from there (by
+        // dual simplex if the current solution breaks the constraint)
+        // instead of from Prepare(). The revised method hands over to the
+        // tableau one first. Returns false, adding nothing, if a column is
+        // not a variable.
+        bool addConstraint(const std::vector<SparseMatrix::Entry> &entries, double rhs)
+        {
+            unsigned int
+                NC = NumberOfConstraints(),
+                NV = NumberOfVariables();
+
+            for (std::size_t e = 0; e < entries.size(); e++)
+            {
+                if (entries[e].first >= NV)
+                    return false;
+            }
+            bool prepared = isPrepared();
+            constraints.addRow(entries, rhs);
+            if (!prepared)
+                return true;
+
+            toTableau();
+            Tableau T(NC + 3, NV + 2);
+            for (unsigned int I = 0; I <= NC + 1; I++)
+                std::copy(TS[I], TS[I] + TS.stride(), T[I]);
+
+            // the new slack is rhs - a x, with each basic x_j replaced by
+            // its row; the zeros are -0.0 as in Prepare()
+            unsigned int R = NC + 2;
+            std::vector<unsigned int> row, column;
+            positions(row, column);
+            T[R][0] = NV + NC + 1;
+            T[R][1] = rhs;
+            for (unsigned int J = 2; J <= NV + 1; J++)
+                T[R][J] = -0.0;
+            for (std::size_t e = constraints.start[NC]; e < constraints.start[NC + 1]; e++)
+            {
+                unsigned int j = constraints.index[e] + 1;
+                double a = constraints.value[e];
+                if (column[j])
+                {
+                    T[R][column[j]] -= a;
+                    continue;
+                }
+
+                for (unsigned int J = 1; J <= NV + 1; J++)
+                    T[R][J] -= a * T[row[j]][J];
+            }
+
+            TS.swap(T);
+            weights.push_back(1.0);
+            resume();
+            return true;
+        }
+
+        // Sets the right hand side of constraint {i} (from 0) of a prepared
+        // problem to {rhs}, updating the current basic solution, and goes
+        // on as addConstraint() does. Returns false if there is no such
+        // constraint.
+        bool setRhs(unsigned int i, double rhs)
+        {
+            unsigned int NC = NumberOfConstraints();
+            if (i >= NC)
+                return false;
+
+            double delta = rhs - constraints.rhs[i];
+            constraints.rhs[i] = rhs;
+            if (!isPrepared())
+                return true;
+
+            // b moves by delta e_i, so the basic solution by delta B^-1 e_i:
+            // that is the slack's own row if it is basic, minus its column
+            // (objective included) if not
+            toTableau();
+            std::vector<unsigned int> row, column;
+            positions(row, column);
+            unsigned int slack = NumberOfVariables() + 1 + i;
+            if (column[slack])
+            {
+                for (unsigned int I = 1; I <= NC + 1; I++)
+                    TS[I][1] -= delta * TS[I][column[slack]];
+            }
+            else
+            {
+                TS[row[slack]][1] += delta;
+            }
+
+            resume();
+            return true;
+        }
+
         void print()
+        {
+            if (revised)
+            {
+                Tableau T;
+                revised->dictionary(T, true);
+                print(T);
+            }
+            else
+            {
+                print(TS);
+            }
+        }
+
+        void result()
+        {
+            if (revised)
+            {
+                Tableau T;
+                revised->dictionary(T, false);
+                result(T);
+            }
+            else
+            {
+                result(TS);
+            }
+        }
+
+    private:
+        void print(const Tableau &TS)
         {
             unsigned int
                 NC = NumberOfConstraints(),
@@ -202,18 +671,22 @@ namespace simplex
             {
                 std::cout
                     << "    x"
-                    << std::setprecision(0)
-                    << TS[0][i]
+                    << (unsigned int)TS[0][i]
                     << "   |";
             }
             std::cout << "\n" << repeat("---------+",(NV + 2)) << "\n";
 
             for (unsigned int j = 1; j <= NC + 1; j++)
             {
+                std::stringstream label;
+                if (j == 1)
+                    label << "z ";
+                else
+                    label << "x" << (unsigned int)TS[j][0];
+
                 std::cout
-                    << "      "
-                    << (j == 1 ? 'z' : 'x')
-                    << (j == 1 ? ' ' : (char)('0' + TS[j][0]))
+                    << std::setw(8)
+                    << label.str()
                     << " |";
 
                 for (unsigned int i = 1; i <= NV + 1; i++)
@@ -234,7 +707,7 @@ namespace simplex
             std::cout << "\n" << repeat("---------+", (NV + 2)) << "\n";
         }
 
-        void result()
+        void result(const Tableau &TS)
         {
             unsigned int I, J;
             unsigned int
@@ -245,6 +718,26 @@ namespace simplex
             {
                 std::cout << "No solution!" << std::endl;
             }
+            else if (presolved && presolved->isApplied())
+            {
+                // the basic ones and those presolve left away from 0
+                std::vector<double> x;
+                std::vector<bool> basic;
+                values(TS, x, basic);
+
+                for (I = 1; I <= presolved->NumberOfVariables(); I++)
+                {
+                    double v = presolved->postsolve(I - 1, x);
+                    bool kept = presolved->isKept(I - 1);
+                    if ((kept && basic[presolved->presolvedIndex(I - 1)]) || v != 0.0)
+                        std::cout
+                            << "Variable #" << I << ": "
+                            << v << std::endl;
+                }
+                std::cout
+                    << "Function: "
+                    << TS[1][1] << std::endl;
+            }
             else
             {
                 for (I = 1; I <= NV; I++)
@@ -262,6 +755,252 @@ namespace simplex
                     << TS[1][1] << std::endl;
             }
         }
+
+        // The structural variables of {TS}, and which are basic
+        void values(const Tableau &TS, std::vector<double> &x, std::vector<bool> &basic)
+        {
+            unsigned int
+                NC = NumberOfConstraints(),
+                NV = NumberOfVariables();
+
+            x.assign(NV, 0.0);
+            basic.assign(NV, false);
+            for (unsigned int I = 2; I <= NC + 1; I++)
+            {
+                unsigned int j = (unsigned int)TS[I][0];
+                if (j <= NV)
+                {
+                    x[j - 1] = TS[I][1];
+                    basic[j - 1] = true;
+                }
+            }
+        }
+
+        void restart()
+        {
+            counters = Counters();
+            stalled = 0;
+            setPricing(rule);
+        }
+
+        // Books a pivot whose leaving variable is at {step}
+        void count(double step, bool bland)
+        {
+            counters.pivots++;
+            if (bland)
+                counters.bland++;
+
+            if (fabs(step) <= TOLERANCE)
+            {
+                counters.degenerate++;
+                stalled++;
+            }
+            else
+            {
+                stalled = 0;
+            }
+        }
+
+        // Is no reduced cost positive (the basis optimal but for feasibility)?
+        // Rounding may leave some a little above 0 after many pivots.
+        bool isDualFeasible()
+        {
+            unsigned int NV = NumberOfVariables();
+            for (unsigned int J = 2; J <= NV + 1; J++)
+            {
+                if (TS[1][J] > TOLERANCE)
+                    return false;
+            }
+            return true;
+        }
+
+        // Dual simplex: the row of the most negative basic variable (the
+        // first one on a tie), or with {bland} the negative one of the
+        // lowest label; 0 if none is negative (below -TOLERANCE, as in
+        // Optimize())
+        unsigned int dualLeaving(bool bland)
+        {
+            unsigned int NC = NumberOfConstraints();
+            unsigned int P = 0;
+            double XMIN = 0.0;
+
+            for (unsigned int I = 2; I <= NC + 1; I++)
+            {
+                if (!(TS[I][1] < -TOLERANCE))
+                    continue;
+
+                if (bland ? P == 0 || TS[I][0] < TS[P][0] : TS[I][1] < XMIN)
+                {
+                    XMIN = TS[I][1];
+                    P = I;
+                }
+            }
+            return P;
+        }
+
+        // ... and the column that enters for row P1: the first smallest
+        // |TS[1][J] / TS[P1][J]| with TS[P1][J] > 0 (then the lowest label
+        // with {bland}); 0 if none, the problem being infeasible
+        unsigned int dualEntering(bool bland)
+        {
+            unsigned int NV = NumberOfVariables();
+            unsigned int P = 0;
+            double RAP = HUGE_VAL;
+
+            for (unsigned int J = 2; J <= NV + 1; J++)
+            {
+                if (!(TS[P1][J] > 0.0))
+                    continue;
+
+                double V = fabs(TS[1][J] / TS[P1][J]);
+                if (V < RAP || (bland && V == RAP && TS[0][J] < TS[0][P]))
+                {
+                    RAP = V;
+                    P = J;
+                }
+            }
+            return P;
+        }
+
+        // Where each variable (by label) is: its row if basic, its column
+        // if not (0 in the other)
+        void positions(std::vector<unsigned int> &row, std::vector<unsigned int> &column)
+        {
+            unsigned int
+                NC = NumberOfConstraints(),
+                NV = NumberOfVariables();
+
+            row.assign(NV + NC + 1, 0);
+            column.assign(NV + NC + 1, 0);
+            for (unsigned int J = 2; J <= NV + 1; J++)
+                column[(unsigned int)TS[0][J]] = J;
+            for (unsigned int I = 2; I < TS.rows(); I++)
+                row[(unsigned int)TS[I][0]] = I;
+        }
+
+        // Is there a basis to change (else Prepare() takes the change in)?
+        bool isPrepared()
+        {
+            if (objective == VOID)
+                return false;
+            return revised || TS.rows() == NumberOfConstraints() + 2;
+        }
+
+        // The revised method carries on as the tableau of its basis
+        void toTableau()
+        {
+            if (!revised)
+                return;
+
+            revised->dictionary(TS, true);
+            revised.reset();
+        }
+
+        // After a change to a solved (or partly solved) problem
+        void resume()
+        {
+            P1 = P2 = 0;
+            error = isOptimal = false;
+            stalled = 0;
+        }
+
+        // The entering column under the rule, 0 if none improves
+        unsigned int entering(bool bland)
+        {
+            unsigned int
+                NC = NumberOfConstraints(),
+                NV = NumberOfVariables();
+            unsigned int I, J, P = 0;
+            double XMAX = 0.0;
+
+            if (bland)
+            {
+                for (J = 2; J <= NV + 1; J++)
+                {
+                    if (TS[1][J] > 0.0 && (P == 0 || TS[0][J] < TS[0][P]))
+                        P = J;
+                }
+                return P;
+            }
+
+            if (rule == pricing::PARTIAL)
+            {
+                unsigned int size = pricing::segmentSize(NV);
+                unsigned int segments = (NV + size - 1) / size;
+                for (unsigned int s = 0; s < segments && P == 0; s++)
+                {
+                    unsigned int current = (segment + s) % segments;
+                    unsigned int last = std::min(NV, (current + 1) * size) + 1;
+                    for (J = current * size + 2; J <= last; J++)
+                    {
+                        if (TS[1][J] > XMAX)
+                        {
+                            XMAX = TS[1][J];
+                            P = J;
+                        }
+                    }
+                    if (P != 0)
+                        segment = (current + 1) % segments;
+                }
+                return P;
+            }
+
+            // steepest edge: the exact 1 + |B^-1 a_j|^2, from the columns
+            std::vector<double> norms;
+            if (rule == pricing::STEEPEST_EDGE)
+            {
+                norms.assign(NV + 2, 1.0);
+                for (I = 2; I <= NC + 1; I++)
+                {
+                    const double *row = TS[I];
+                    for (J = 2; J <= NV + 1; J++)
+                        norms[J] += row[J] * row[J];
+                }
+            }
+
+            for (J = 2; J <= NV + 1; J++)
+            {
+                if (!(TS[1][J] > 0.0))
+                    continue;
+
+                double w = 1.0;
+                if (rule == pricing::DEVEX)
+                    w = weights[(unsigned int)TS[0][J]];
+                else if (rule == pricing::STEEPEST_EDGE)
+                    w = norms[J];
+
+                double score = pricing::score(rule, TS[1][J], w);
+                if (score > XMAX)
+                {
+                    XMAX = score;
+                    P = J;
+                }
+            }
+            return P;
+        }
+
+        // Devex weights for the pivot on TS[P1][P2], before Formula()
+        // changes the pivot row (the labels are already swapped)
+        void devex()
+        {
+            unsigned int NV = NumberOfVariables();
+            double wq = weights[(unsigned int)TS[P1][0]];
+            bool reset = false;
+
+            for (unsigned int J = 2; J <= NV + 1; J++)
+            {
+                if (J == P2 || TS[P1][J] == 0.0)
+                    continue;
+
+                double &w = weights[(unsigned int)TS[0][J]];
+                w = pricing::devex(w, TS[P1][J] / TS[P1][P2], wq);
+                reset = reset || w > pricing::DEVEX_RESET;
+            }
+            weights[(unsigned int)TS[0][P2]] = pricing::leaving(wq, TS[P1][P2]);
+
+            if (reset)
+                weights.assign(weights.size(), 1.0);
+        }
 };
 
     class Parser
@@ -272,6 +1011,7 @@ namespace simplex
             OBJECTIVE,
             VARIABLES,
             CONSTRAINTS,
+            INTEGER,
             IGNORE
         };
 
@@ -287,92 +1027,294 @@ namespace simplex
             Problem &p = problem;
 
             Reader reader(filename);
+            StringView source(reader.file.data(), reader.file.size());
+
+            if (reader.file.is_open() && loadSnapshot(snapshotName(filename), source))
+            {
+                std::cout << "Loaded snapshot [" << snapshotName(filename) << "]" << std::endl;
+                p.Prepare();
+                return;
+            }
 
             Mode mode = IGNORE;
-            std::string line;
+            StringView line;
             std::size_t line_id;
             while (reader.getLine(line, line_id))
+                read(p, mode, line, line_id);
+
+            if (reader.file.is_open())
+                saveSnapshot(snapshotName(filename), source);
+
+            p.Prepare();
+        }
+
+        // Hands the problem over; the parser is left empty
+        Problem getProblem() { return std::move(problem); }
+
+        // Reads one line of an input file into {p}; {mode} is the section
+        // the line is in, and is updated by the section headers
+        static void read(Problem &p, Mode &mode, StringView line, std::size_t line_id)
+        {
+            //mode
             {
-                //mode
+                if (iequals(line, "[objective]"))
                 {
-                    std::string line_low = line;
-                    std::transform(line_low.begin(), line_low.end(), line_low.begin(), ::tolower);
-                    if (line_low.compare("[objective]") == 0)
-                    {
-                        mode = OBJECTIVE;
-                        continue;
-                    }
-                    if (line_low.compare("[variables]") == 0)
-                    {
-                        mode = VARIABLES;
-                        continue;
-                    }
-                    if (line_low.compare("[constraints]") == 0)
-                    {
-                        mode = CONSTRAINTS;
-                        continue;
-                    }
+                    mode = OBJECTIVE;
+                    return;
+                }
+                if (iequals(line, "[variables]"))
+                {
+                    mode = VARIABLES;
+                    return;
+                }
+                if (iequals(line, "[constraints]"))
+                {
+                    mode = CONSTRAINTS;
+                    return;
                 }
+                if (iequals(line, "[integer]"))
+                {
+                    mode = INTEGER;
+                    return;
+                }
+            }
+
+            if (mode == OBJECTIVE)
+            {
+                if (iequals(line, "maximize"))
+                    p.objective = Problem::MAXIMIZE;
+                if (iequals(line, "minimize"))
+                    p.objective = Problem::MINIMIZE;
+
+                return;
+            }
+
+            if (mode == VARIABLES)
+            {
+                std::size_t first = p.variables.size();
 
-                if (mode == OBJECTIVE)
+                Tokenizer tokens(line, ",");
+                for (Tokenizer::iterator it = tokens.begin(); it != tokens.end(); ++it)
                 {
-                    std::string line_low = line;
-                    std::transform(line_low.begin(), line_low.end(), line_low.begin(), ::tolower);
-                    if (line_low.compare("maximize") == 0)
-                        p.objective = Problem::MAXIMIZE;
-                    if (line_low.compare("minimize") == 0)
-                        p.objective = Problem::MINIMIZE;
+                    double v;
+                    tools::parse(*it, v);
+                    p.variables.push_back(v);
+                }
 
-                    continue;
+                if (p.variables.size() - first < 2)
+                {
+                    p.variables.resize(first);
+                    std::cerr << "Parser: ERROR! Bad format on line: " << line_id << std::endl;
                 }
 
-                if (mode == VARIABLES)
+                return;
+            }
+
+            if (mode == CONSTRAINTS)
+            {
+                if (line.find(':') != StringView::npos)
                 {
-                    std::vector<std::string> tokens = tools::split(line, ",");
-                    if (tokens.size() < 2)
-                    {
+                    if (!parseSparse(p, line))
                         std::cerr << "Parser: ERROR! Bad format on line: " << line_id << std::endl;
-                        continue;
-                    }
+                    return;
+                }
 
-                    for (unsigned int j = 0; j < tokens.size(); j++)
-                    {
-                        double v = atof(tokens[j].c_str());
-                        p.variables.push_back(v);
-                    }
+                std::vector < double > vec;
 
-                    continue;
+                Tokenizer tokens(line, ",");
+                for (Tokenizer::iterator it = tokens.begin(); it != tokens.end(); ++it)
+                {
+                    double v;
+                    tools::parse(*it, v);
+                    vec.push_back(v);
                 }
 
-                if (mode == CONSTRAINTS)
+                if (vec.size() < 2)
                 {
-                    std::vector<std::string> tokens = tools::split(line, ",");
-                    if (tokens.size() < 2)
+                    std::cerr << "Parser: ERROR! Bad format on line: " << line_id << std::endl;
+                    return;
+                }
+                p.constraints.addDenseRow(vec);
+
+                return;
+            }
+
+            if (mode == INTEGER)
+            {
+                // variables, the first one is 1
+                std::vector<unsigned int> integers;
+
+                Tokenizer tokens(line, ",");
+                for (Tokenizer::iterator it = tokens.begin(); it != tokens.end(); ++it)
+                {
+                    int j;
+                    if (!tools::parse(trim(*it), j) || j < 1)
                     {
                         std::cerr << "Parser: ERROR! Bad format on line: " << line_id << std::endl;
-                        continue;
+                        return;
                     }
+                    integers.push_back(j - 1);
+                }
+                p.integers.insert(p.integers.end(), integers.begin(), integers.end());
 
-                    std::vector < double > vec;
-                    for (unsigned int j = 0; j < tokens.size(); j++)
-                    {
-                        double v = atof(tokens[j].c_str());
-                        vec.push_back(v);
-                    }
-                    p.constraints.push_back(vec);
+                return;
+            }
+        }
+
+    private:
+        static const uint32_t SNAPSHOT_KIND = 0x584C5053; // "SPLX"
+
+        Problem
+            problem;
+
+        // A sparse row: "column:value" pairs (columns count from 1, as in
+        // X1, X2...) and the right hand side last, e.g. "1:3, 7:-2.5, 10"
+        static bool parseSparse(Problem &p, StringView line)
+        {
+            std::vector<SparseMatrix::Entry> entries;
+            double rhs = 0;
+            bool closed = false;
 
+            Tokenizer tokens(line, ",");
+            for (Tokenizer::iterator it = tokens.begin(); it != tokens.end(); ++it)
+            {
+                if (closed)
+                    return false;   // something after the right hand side
+
+                std::size_t colon = it->find(':');
+                if (colon == StringView::npos)
+                {
+                    if (!tools::parse(*it, rhs))
+                        return false;
+                    closed = true;
                     continue;
                 }
+
+                int column;
+                double v;
+                if (!tools::parse(trim(it->substr(0, colon)), column) || column < 1 || !tools::parse(trim(it->substr(colon + 1)), v))
+                    return false;
+                entries.push_back(SparseMatrix::Entry(column - 1, v));
             }
 
-            p.Prepare();
+            if (!closed)
+                return false;
+            p.constraints.addRow(entries, rhs);
+            return true;
         }
 
-        Problem getProblem() { return problem; }
+        // payload: objective, variables (count, values), then the constraints
+        // in CSR form: dense width, ragged flag, rows, row starts, non-zeros,
+        // columns, values and right hand sides, and last the integer
+        // variables (count, indices)
+        void saveSnapshot(std::string filename, StringView source)
+        {
+            Problem &p = problem;
+            SparseMatrix &A = p.constraints;
+            SnapshotWriter snap(SNAPSHOT_KIND);
 
-    private:
-        Problem
-            problem;
+            snap.put((int32_t)p.objective);
+
+            snap.put((uint64_t)p.variables.size());
+            if (!p.variables.empty())
+                snap.write(&p.variables[0], p.variables.size() * sizeof(double));
+
+            snap.put((uint32_t)A.denseWidth());
+            snap.put((uint8_t)A.isRagged());
+            snap.put((uint64_t)A.rows());
+            for (unsigned int i = 0; i <= A.rows(); i++)
+                snap.put((uint64_t)A.start[i]);
+            snap.put((uint64_t)A.nonZeros());
+            if (A.nonZeros())
+            {
+                snap.write(&A.index[0], A.nonZeros() * sizeof(unsigned int));
+                snap.write(&A.value[0], A.nonZeros() * sizeof(double));
+            }
+            if (A.rows())
+                snap.write(&A.rhs[0], A.rows() * sizeof(double));
+
+            snap.put((uint64_t)p.integers.size());
+            if (!p.integers.empty())
+                snap.write(&p.integers[0], p.integers.size() * sizeof(unsigned int));
+
+            snap.save(filename, source);
+        }
+
+        bool loadSnapshot(std::string filename, StringView source)
+        {
+            Problem &p = problem;
+            SnapshotReader snap(filename, SNAPSHOT_KIND, source);
+            if (!snap.is_valid())
+                return false;
+
+            int32_t objective = 0;
+            uint64_t count = 0;
+            snap.get(objective);
+            snap.get(count);
+            if (!snap.is_valid() || count > source.size())
+                return false;
+
+            std::vector<double> variables((std::size_t)count);
+            if (count)
+                snap.read(&variables[0], variables.size() * sizeof(double));
+
+            uint32_t width = 0;
+            uint8_t ragged = 0;
+            snap.get(width);
+            snap.get(ragged);
+            snap.get(count);
+            if (!snap.is_valid() || count > source.size())
+                return false;
+
+            std::vector<std::size_t> start((std::size_t)count + 1);
+            for (std::size_t i = 0; i < start.size() && snap.is_valid(); i++)
+            {
+                uint64_t offset = 0;
+                snap.get(offset);
+                start[i] = (std::size_t)offset;
+            }
+            std::vector<double> rhs((std::size_t)count);
+
+            snap.get(count);
+            if (!snap.is_valid() || count > source.size())
+                return false;
+
+            std::vector<unsigned int> index((std::size_t)count);
+            std::vector<double> value((std::size_t)count);
+            if (count)
+            {
+                snap.read(&index[0], index.size() * sizeof(unsigned int));
+                snap.read(&value[0], value.size() * sizeof(double));
+            }
+            if (!rhs.empty())
+                snap.read(&rhs[0], rhs.size() * sizeof(double));
+
+            snap.get(count);
+            if (!snap.is_valid() || count > source.size())
+                return false;
+
+            std::vector<unsigned int> integers((std::size_t)count);
+            if (count)
+                snap.read(&integers[0], integers.size() * sizeof(unsigned int));
+
+            if (!snap.done())
+                return false;
+
+            SparseMatrix constraints;
+            if (!constraints.assign(start, index, value, rhs, width, ragged != 0))
+                return false;
+
+            switch (objective)
+            {
+            case Problem::MAXIMIZE: p.objective = Problem::MAXIMIZE; break;
+            case Problem::MINIMIZE: p.objective = Problem::MINIMIZE; break;
+            default: p.objective = Problem::VOID; break;
+            }
+            p.variables.swap(variables);
+            p.constraints = std::move(constraints);
+            p.integers.swap(integers);
+            return true;
+        }
     };
 }
 
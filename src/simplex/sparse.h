@@ -0,0 +1,172 @@
+#ifndef SIMPLEX_SPARSE_H
+#define SIMPLEX_SPARSE_H
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <utility>
+
+namespace simplex
+{
+    // Constraint rows in compressed sparse row (CSR) form: the entries of
+    // row i are index[start[i] .. start[i + 1]) and value[..], sorted by
+    // column, with no zeros. Each row also keeps its right hand side.
+    //
+    // transpose() gives the compressed sparse column (CSC) form: the rows of
+    // the transposed matrix are the columns of this one.
+    class SparseMatrix
+    {
+    public:
+        typedef std::pair<unsigned int, double> Entry;  // column, value
+
+        SparseMatrix() :
+            _cols(0),
+            _width(0),
+            _ragged(false)
+        {
+            start.push_back(0);
+        };
+
+        unsigned int rows() const { return (unsigned int)rhs.size(); }
+
+        // 1 + the largest column with an entry
+        unsigned int cols() const { return _cols; }
+
+        std::size_t nonZeros() const { return value.size(); }
+
+        // Columns of the dense rows (0 if none were added)
+        unsigned int denseWidth() const { return _width; }
+
+        // Were dense rows of different widths added?
+        bool isRagged() const { return _ragged; }
+
+        void clear()
+        {
+            start.assign(1, 0);
+            index.clear();
+            value.clear();
+            rhs.clear();
+            _cols = _width = 0;
+            _ragged = false;
+        }
+
+        // {entries} in any order; repeated columns are added up
+        void addRow(std::vector<Entry> entries, double b)
+        {
+            std::sort(entries.begin(), entries.end());
+            for (std::size_t e = 0; e < entries.size(); e++)
+            {
+                unsigned int j = entries[e].first;
+                double v = entries[e].second;
+                while (e + 1 < entries.size() && entries[e + 1].first == j)
+                    v += entries[++e].second;
+
+                if (v != 0.0)
+                    push(j, v);
+            }
+            close(b);
+        }
+
+        // {row} holds every column, then the right hand side
+        void addDenseRow(const std::vector<double> &row)
+        {
+            unsigned int width = (unsigned int)row.size() - 1;
+            if (_width != 0 && width != _width)
+                _ragged = true;
+            _width = std::max(_width, width);
+
+            for (unsigned int j = 0; j < width; j++)
+            {
+                if (row[j] != 0.0)
+                    push(j, row[j]);
+            }
+            close(row[width]);
+        }
+
+        // Takes over the arrays of another matrix (e.g. from a snapshot).
+        // Returns false, leaving the matrix empty, if they do not fit together.
+        bool assign(std::vector<std::size_t> &_start, std::vector<unsigned int> &_index, std::vector<double> &_value, std::vector<double> &_rhs, unsigned int width, bool ragged)
+        {
+            clear();
+            if (_start.size() != _rhs.size() + 1 || _start[0] != 0 || _start.back() != _index.size() || _index.size() != _value.size())
+                return false;
+            for (std::size_t i = 0; i + 1 < _start.size(); i++)
+            {
+                if (_start[i] > _start[i + 1])
+                    return false;
+            }
+
+            start.swap(_start);
+            index.swap(_index);
+            value.swap(_value);
+            rhs.swap(_rhs);
+            for (std::size_t e = 0; e < index.size(); e++)
+                _cols = std::max(_cols, index[e] + 1);
+            _width = width;
+            _ragged = ragged;
+            return true;
+        }
+
+        // Rows are columns, columns are rows; the right hand sides are 0
+        void transpose(SparseMatrix &t, unsigned int cols) const
+        {
+            cols = std::max(cols, _cols);
+
+            t.clear();
+            t.start.assign(cols + 1, 0);
+            for (std::size_t e = 0; e < index.size(); e++)
+                t.start[index[e] + 1]++;
+            for (unsigned int j = 0; j < cols; j++)
+                t.start[j + 1] += t.start[j];
+
+            // rows in order, so each column comes out sorted
+            std::vector<std::size_t> next(t.start.begin(), t.start.end() - 1);
+            t.index.resize(index.size());
+            t.value.resize(value.size());
+            for (unsigned int i = 0; i < rows(); i++)
+            {
+                for (std::size_t e = start[i]; e < start[i + 1]; e++)
+                {
+                    std::size_t to = next[index[e]]++;
+                    t.index[to] = i;
+                    t.value[to] = value[e];
+                }
+            }
+
+            t.rhs.assign(cols, 0.0);
+            for (std::size_t e = 0; e < t.index.size(); e++)
+                t._cols = std::max(t._cols, t.index[e] + 1);
+        }
+
+        std::vector<std::size_t>
+            start;  // rows() + 1 offsets into index and value
+        std::vector<unsigned int>
+            index;  // column of each entry
+        std::vector<double>
+            value,
+            rhs;    // one per row
+
+    private:
+        unsigned int
+            _cols,
+            _width;
+        bool
+            _ragged;
+
+        void push(unsigned int j, double v)
+        {
+            index.push_back(j);
+            value.push_back(v);
+            if (j + 1 > _cols)
+                _cols = j + 1;
+        }
+
+        void close(double b)
+        {
+            rhs.push_back(b);
+            start.push_back(index.size());
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef SIMPLEX_TABLEAU_H
+#define SIMPLEX_TABLEAU_H
+
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <utility>
+#include <stdint.h>
+
+namespace simplex
+{
+    // Row-major simplex tableau on the heap.
+    //
+    // Every row starts on a 64 byte boundary and is padded with zeros to a
+    // multiple of 8 doubles, so rows never share a cache line and vector
+    // code can run over whole rows without a scalar tail. t[i][j] reads as
+    // with a plain 2D array.
+    //
+    // A tableau owns its storage: it can be moved but not copied.
+    class Tableau
+    {
+    public:
+        enum
+        {
+            ALIGNMENT = 64,                         // bytes
+            PADDING = ALIGNMENT / sizeof(double)    // row length is a multiple of this
+        };
+
+        Tableau() :
+            _block(NULL),
+            _data(NULL),
+            _rows(0),
+            _cols(0),
+            _stride(0)
+        {};
+
+        Tableau(unsigned int rows, unsigned int cols) :
+            _block(NULL),
+            _data(NULL),
+            _rows(0),
+            _cols(0),
+            _stride(0)
+        {
+            resize(rows, cols);
+        };
+
+        Tableau(Tableau &&other) :
+            _block(NULL),
+            _data(NULL),
+            _rows(0),
+            _cols(0),
+            _stride(0)
+        {
+            swap(other);
+        };
+
+        Tableau& operator=(Tableau &&other)
+        {
+            Tableau(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        ~Tableau()
+        {
+            delete[] _block;
+        };
+
+        // Discards the contents: the new tableau is all zeros
+        void resize(unsigned int rows, unsigned int cols)
+        {
+            std::size_t stride = (cols + PADDING - 1) / PADDING * PADDING;
+            std::size_t bytes = (std::size_t)rows * stride * sizeof(double);
+
+            char *block = new char[bytes + ALIGNMENT];
+            double *data = (double*)(((uintptr_t)block + ALIGNMENT - 1) & ~(uintptr_t)(ALIGNMENT - 1));
+            std::memset(data, 0, bytes);
+
+            delete[] _block;
+            _block = block;
+            _data = data;
+            _rows = rows;
+            _cols = cols;
+            _stride = (unsigned int)stride;
+        }
+
+        void swap(Tableau &other)
+        {
+            std::swap(_block, other._block);
+            std::swap(_data, other._data);
+            std::swap(_rows, other._rows);
+            std::swap(_cols, other._cols);
+            std::swap(_stride, other._stride);
+        }
+
+        unsigned int rows() const { return _rows; }
+        unsigned int cols() const { return _cols; }
+        unsigned int stride() const { return _stride; } // doubles from one row to the next
+
+        double* operator[](unsigned int i) { return _data + (std::size_t)i * _stride; }
+        const double* operator[](unsigned int i) const { return _data + (std::size_t)i * _stride; }
+
+    private:
+        char
+            *_block;    // as allocated
+        double
+            *_data;     // _block, aligned
+        unsigned int
+            _rows,
+            _cols,
+            _stride;
+
+        Tableau(const Tableau &);
+        Tableau& operator=(const Tableau &);
+    };
+}
+
+#endif
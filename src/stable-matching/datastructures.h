@@ -11,6 +11,8 @@
 #include <iomanip>
 
 #include "../common/string.h"
+#include "engine.h"
+#include "events.h"
 #include "stable-matching-tools.h"
 
 namespace stable_matching
@@ -94,16 +96,23 @@ namespace stable_matching
         virtual Members& self() { return *this; }
     };
 
-    class Relationships
+    template <class Events = TraceEvents>
+    class BasicRelationships
         : public TableContainer<std::map<std::string, std::string> >
     {
     public:
+        Events events;
+
+        BasicRelationships(Events _events = Events()) :
+            events(_events)
+        {};
+
         bool exist(std::string key1, std::string key2)
         {
             iterator f1 = table.find(key1);
             bool ret = (f1 != table.end() && f1->second.compare(key2) == 0);
 
-            std::cout << key1 << " -?- " << key2 << " >> " << (ret?"yes":"no") << std::endl;
+            events.exist(key1, key2, ret);
 
             return ret;
         };
@@ -119,7 +128,7 @@ namespace stable_matching
         bool is_single(std::string key1, bool print = false)
         {
             bool ret = (table.find(key1) == table.end());
-            if(print) std::cout << "Is {" << key1 << "} single? " << (!ret ? "yes" : "no") << std::endl;
+            if(print) events.is_single(key1, ret);
             return ret;
         };
 
@@ -133,7 +142,7 @@ namespace stable_matching
             {
                 f2 = table.find(f1->second);
 
-                std::cout << key << " -x- " << f1->second << std::endl;
+                events.freed(key, f1->second);
 
                 table.erase(f1);
                 table.erase(f2);
@@ -147,11 +156,11 @@ namespace stable_matching
                 table.insert(Table::value_type(key1, key2));
                 table.insert(Table::value_type(key2, key1));
 
-                std::cout << key1 << " <-> " << key2 << std::endl;
+                events.added(key1, key2, true);
             }
             else
             {
-                std::cout << key1 << " -x- " << key2 << " Error creating relationship, are they both single?" << std::endl;
+                events.added(key1, key2, false);
             }
         }
 
@@ -179,6 +188,8 @@ namespace stable_matching
         };
     };
 
+    typedef BasicRelationships<TraceEvents> Relationships;
+
     class Preferences
         : public TableContainer<std::map<std::string, std::vector<std::string> > >
     {
@@ -211,25 +222,62 @@ namespace stable_matching
     };
 
 
-    class Population
+    // Read-only view of a preference row of an Engine as IDs, from its
+    // start or from the first entry not proposed to yet: what used to be
+    // the std::vector and std::queue of IDs of each Person
+    class PreferenceView
     {
-    friend class Person;
+    public:
+        PreferenceView(const Engine &engine, Engine::Index i, bool remaining) :
+            _engine(&engine),
+            _i(i),
+            _remaining(remaining)
+        {};
+
+        std::size_t size() const { return _engine->countPreferences(_i) - first(); }
+        bool empty() const { return size() == 0; }
+
+        const std::string& operator[](std::size_t j) const { return _engine->id(_engine->preferences(_i)[first() + j]); }
+        const std::string& front() const { return (*this)[0]; }
+        const std::string& back() const { return (*this)[size() - 1]; }
+
     private:
-        Members
-            members;
-        Preferences
-            pref;
-        Relationships
-            relations;
+        const Engine
+            *_engine;
+        Engine::Index
+            _i;
+        bool
+            _remaining;
+
+        std::size_t first() const { return _remaining ? _engine->proposed(_i) : 0; }
+    };
 
+    // Thin, string based view over an Engine. Men and women are Person
+    // objects addressed by their ID, while all the matching work happens on
+    // the engine's integer indices. {Events} receives what happens on each
+    // proposal (see events.h).
+    template <class Events = TraceEvents>
+    class BasicPopulation
+    {
     public:
+        class Person;
+        friend class Person;
+
+    private:
+        Engine
+            engine;
+
+    public:
+        Events
+            events;
+
         class Person
         {
-            friend class Population;
+            friend class BasicPopulation;
 
         public:
-            std::queue<std::string> preferences;
-            std::vector<std::string> all_preferences;
+            PreferenceView preferences;     // not proposed to yet, front() is the next
+            PreferenceView all_preferences;
 
             std::string id;
             enum Response
@@ -239,34 +287,44 @@ namespace stable_matching
             };
 
         private:
-            std::string couple_id;
-            Population* _population;
-
-            Person(std::string _id, std::vector<std::string> _preferences, Population& _pop) :
-                all_preferences(_preferences),
-                id(_id),
-                couple_id(""),
+            Engine::Index _index;
+            BasicPopulation* _population;
+
+            Person(Engine::Index index, BasicPopulation& _pop) :
+                preferences(_pop.engine, index, true),
+                all_preferences(_pop.engine, index, false),
+                id(_pop.engine.id(index)),
+                _index(index),
                 _population(&_pop)
-            {
-                for (unsigned int j = 0; j < _preferences.size(); j++)
-                    preferences.push(_preferences[j]);
-            };
+            {};
 
         public:
+            Engine::Index index() const { return _index; }
+
             Person* nextPreference()
             {
-                if (!preferences.size())
-                    return NULL;
+                return _population->get(_population->engine.nextPreference(_index));
+            }
+
+            std::string name()
+            {
+                return _population->engine.name(_index);
+            }
 
-                ID id = preferences.front();
-                preferences.pop();
+            std::size_t countPreferences()
+            {
+                return _population->engine.countPreferences(_index);
+            }
 
-                return _population->find(id);
+            // ID of the {j}-th preference, 0 is the favourite
+            std::string preference(std::size_t j)
+            {
+                return _population->engine.id(_population->engine.preferences(_index)[j]);
             }
 
-            std::string name()
+            Person* couple()
             {
-                return _population->members.get(id);
+                return _population->get(_population->engine.partner(_index));
             }
 
             Response propose(Person *p)
@@ -278,41 +336,34 @@ namespace stable_matching
 
             Response propose(Person &p)
             {
-                for (unsigned int j = 0; j < p.all_preferences.size(); j++)
+                Engine &e = _population->engine;
+
+                Engine::Index dumped;
+                switch (e.propose(_index, p._index, dumped))
                 {
-                    if (p.all_preferences[j].compare(id) == 0)
-                    {
-                        //break relationship
-                        if (!p.couple_id.empty())
-                        {
-                            std::cout << _population->members.get(p.id) << " dumps " << _population->members.get(p.couple_id);
-                            if (tools::beginsWith(p.couple_id, "m"))
-                            {
-                                _population->single_men.push(p.couple_id);
-                            }
-                            else if (tools::beginsWith(p.couple_id, "f"))
-                            {
-                                _population->single_women.push(p.couple_id);
-                            }
-                            Person *per = _population->find(p.couple_id);
-                            if (per) per->couple_id = "";
-                        }
-                        else
-                        {
-                            std::cout << _population->members.get(p.id) << " is single";
-                        }
-
-                        p.couple_id = id;
-                        couple_id = p.id;
-                        return ACCEPT_PROPOSAL;
-                    }
-                    else if (p.all_preferences[j].compare(p.couple_id) == 0)
+                case Engine::ACCEPTED:
+                    if (dumped != Engine::NONE)
                     {
-                        std::cout << _population->members.get(p.id) << " prefers " << _population->members.get(p.couple_id);
-                        return REJECT_PROPOSAL;
+                        if (e.side(dumped) == Engine::MAN)
+                            _population->single_men.push(e.id(dumped));
+                        else if (e.side(dumped) == Engine::WOMAN)
+                            _population->single_women.push(e.id(dumped));
                     }
+                    _population->events.accepted(e, p._index, _index, dumped);
+                    return ACCEPT_PROPOSAL;
+
+                case Engine::REJECTED:
+                    _population->events.rejected(e, p._index, _index, e.partner(p._index));
+                    return REJECT_PROPOSAL;
+
+                default:
+                    // not in {p}'s list: a rejection in favour of {p}'s
+                    // partner if {p} lists it, silent otherwise
+                    Engine::Index partner = e.partner(p._index);
+                    if (partner != Engine::NONE && e.rank(p._index, partner) != Engine::UNRANKED)
+                        _population->events.rejected(e, p._index, _index, partner);
+                    return REJECT_PROPOSAL;
                 }
-                return REJECT_PROPOSAL;
             };
         };
 
@@ -320,65 +371,67 @@ namespace stable_matching
             men,
             women;
 
-        std::stack <std::string>
-            single_men,
+        std::stack < std::string >
+            single_men,     // IDs
             single_women;
 
-        Population(Members &m, Preferences &p) :
-            members(m),
-            pref(p)
+        BasicPopulation(Members &m, Preferences &p, Events _events = Events()) :
+            events(_events)
         {
 #ifdef __GNUC__
-            for (typename Members::iterator p = members.begin(); p != members.end(); p++)
+            for (typename Members::iterator it = m.begin(); it != m.end(); it++)
 #else
-            for (Members::iterator p = members.begin(); p != members.end(); p++)
+            for (Members::iterator it = m.begin(); it != m.end(); it++)
 #endif
+                engine.add(it->first, it->second);
+
+            for (Engine::Index i = 0; i < engine.count(); i++)
             {
-                Person prs((*p).first, pref.get((*p).first), *this);
+                Preferences::Type list = p.get(engine.id(i));
+                engine.setPreferences(i, list.begin(), list.end());
 
-                if (tools::beginsWith((*p).first, "m"))
+                Person prs(i, *this);
+                if (engine.side(i) == Engine::MAN)
                 {
                     men.push_back(prs);
-                    single_men.push((*p).first);
+                    single_men.push(engine.id(i));
                 }
-                else if (tools::beginsWith((*p).first, "f"))
+                else if (engine.side(i) == Engine::WOMAN)
                 {
                     women.push_back(prs);
-                    single_women.push((*p).first);
+                    single_women.push(engine.id(i));
                 }
             }
         };
 
         Person* find(std::string id)
         {
-            std::vector < Person > *person_list = NULL;
-            if (tools::beginsWith(id, "m")) person_list = &men;
-            else if (tools::beginsWith(id, "f")) person_list = &women;
+            return get(engine.find(id));
+        };
 
-            if (person_list)
-            {
-                for (unsigned int j = 0; j < (person_list)->size(); j++)
-                {
-                    if (id.compare((*person_list)[j].id) == 0)
-                        return &(*person_list)[j];
-                }
-            }
+        // Person with engine index {i}, NULL for Engine::NONE
+        Person* get(Engine::Index i)
+        {
+            if (i == Engine::NONE)
+                return NULL;
 
-            return NULL;
-        };
+            return get(engine.side(i), engine.local(i));
+        }
 
         void print(Person &m)
         {
-            std::cout << std::setw(8) << members.get(m.id).substr(0, 8) << " :   ";
-            for (unsigned int j = 0; j < m.all_preferences.size(); j++)
+            std::cout << std::setw(8) << m.name().substr(0, 8) << " :   ";
+
+            const Engine::Index *p = engine.preferences(m._index);
+            for (unsigned int j = 0; j < engine.countPreferences(m._index); j++)
             {
                 std::cout
                     << "[" <<
                     (
-                    m.couple_id.compare(m.all_preferences[j]) == 0 ?
+                    engine.partner(m._index) == p[j] ?
                     "O" : " "
                     )
-                    << "] " << std::setw(6) << members.get(m.all_preferences[j]).substr(0, 6) << " ";
+                    << "] " << std::setw(6) << engine.name(p[j]).substr(0, 6) << " ";
             }
             std::cout << std::endl;
         }
@@ -407,9 +460,17 @@ namespace stable_matching
             single_women.pop();
             return find(id);
         }
-    };
 
+    private:
+        Person* get(Engine::Side side, unsigned int local)
+        {
+            if (side == Engine::MAN && local < men.size()) return &men[local];
+            if (side == Engine::WOMAN && local < women.size()) return &women[local];
+            return NULL;
+        }
+    };
 
+    typedef BasicPopulation<TraceEvents> Population;
 }
 
 #endif
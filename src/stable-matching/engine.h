@@ -0,0 +1,230 @@
+#ifndef STABLE_MATCHING_ENGINE_H
+#define STABLE_MATCHING_ENGINE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#ifdef __GNUC__
+#include <tr1/unordered_map>
+#else
+#include <unordered_map>
+#endif
+
+#include "../common/string.h"
+
+namespace stable_matching
+{
+    // Dense, integer indexed state of a matching problem.
+    //
+    // Every member is mapped once to an Index (in the order the members are
+    // given). Preference lists are stored as contiguous rows of indices and,
+    // for each side, an inverse-rank matrix answers "where does {b} appear in
+    // {a}'s list?" with a single array read, so a proposal costs O(1).
+    //
+    // Only members of the opposite side are kept in a preference row; unknown
+    // IDs are dropped when the engine is built.
+    class Engine
+    {
+    public:
+        typedef uint32_t Index;
+        typedef uint32_t Rank;
+
+        enum
+        {
+            NONE = 0xFFFFFFFF,      // no member / no partner
+            UNRANKED = 0xFFFFFFFF   // not in the preference list
+        };
+
+        enum Side
+        {
+            MAN = 0,
+            WOMAN = 1,
+            OTHER = 2
+        };
+
+        enum Result
+        {
+            ACCEPTED,   // {to} takes {from}, possibly dumping its partner
+            REJECTED,   // {to} prefers its current partner
+            UNLISTED    // {from} is not in {to}'s list at all
+        };
+
+        Engine()
+        {
+            _count[MAN] = _count[WOMAN] = _count[OTHER] = 0;
+        };
+
+        // Registers a member, returns its index. IDs starting with 'm' are
+        // men and with 'f' women, as in the input files.
+        Index add(tools::StringView id, tools::StringView name)
+        {
+            Index i = find(id);
+            if (i != NONE)
+                return i;
+
+            Side s = OTHER;
+            if (tools::beginsWith(id, "m")) s = MAN;
+            else if (tools::beginsWith(id, "f")) s = WOMAN;
+
+            i = (Index)_ids.size();
+            _ids.push_back(id.str());
+            _names.push_back(name.str());
+            _side.push_back((uint8_t)s);
+            _local.push_back(_count[s]++);
+            _partner.push_back(NONE);
+            _next.push_back(0);
+            _lookup.insert(Lookup::value_type(_ids.back(), i));
+
+            return i;
+        }
+
+        // Sets the preference row of {i}. Call after every member is added
+        // and in increasing order of {i}; members without a row get an
+        // empty one.
+        template <typename Iterator>
+        void setPreferences(Index i, Iterator begin, Iterator end)
+        {
+            while (_row.size() < (std::size_t)i + 1)
+                _row.push_back(_prefs.size());
+
+            Side opposite = side(i) == MAN ? WOMAN : (side(i) == WOMAN ? MAN : OTHER);
+            for (Iterator it = begin; it != end; ++it)
+            {
+                Index j = find(*it);
+                if (j != NONE && opposite != OTHER && side(j) == opposite)
+                    _prefs.push_back(j);
+            }
+            _row.push_back(_prefs.size());
+
+            _rank[MAN].clear();
+            _rank[WOMAN].clear();
+        }
+
+        Index count() const { return (Index)_ids.size(); }
+        Index count(Side s) const { return _count[s]; }
+
+        Index find(tools::StringView id) const
+        {
+            Lookup::const_iterator it = _lookup.find(id.str());
+            return it == _lookup.end() ? NONE : it->second;
+        }
+
+        const std::string& id(Index i) const { return _ids[i]; }
+        const std::string& name(Index i) const { return _names[i]; }
+        Side side(Index i) const { return (Side)_side[i]; }
+        Index local(Index i) const { return _local[i]; } // position within its side
+
+        // preference row of {i}
+        const Index* preferences(Index i) const
+        {
+            return i + 1 < _row.size() && _row[i] < _prefs.size() ? &_prefs[_row[i]] : NULL;
+        }
+        std::size_t countPreferences(Index i) const
+        {
+            return i + 1 < _row.size() ? _row[i + 1] - _row[i] : 0;
+        }
+
+        // Position of {j} in {i}'s preferences (0 is the favourite)
+        Rank rank(Index i, Index j)
+        {
+            Side s = side(i);
+            if (s == OTHER || side(j) == OTHER || side(j) == s)
+                return UNRANKED;
+
+            std::vector<Rank> &table = ranks(s);
+            Side o = s == MAN ? WOMAN : MAN;
+            return table[(std::size_t)_local[i] * _count[o] + _local[j]];
+        }
+
+        Index partner(Index i) const { return _partner[i]; }
+
+        // Entries of {i}'s list it has proposed to so far
+        std::size_t proposed(Index i) const { return _next[i]; }
+
+        // Next entry of {i}'s list that {i} has not proposed to yet
+        Index nextPreference(Index i)
+        {
+            if (_next[i] >= countPreferences(i))
+                return NONE;
+            return _prefs[_row[i] + _next[i]++];
+        }
+
+        // {from} proposes to {to}. On ACCEPTED, {dumped} is set to the former
+        // partner of {to} (or NONE), whose pairing is dissolved.
+        Result propose(Index from, Index to, Index &dumped)
+        {
+            dumped = NONE;
+
+            Rank r = rank(to, from);
+            if (r == UNRANKED)
+                return UNLISTED;
+
+            Index current = _partner[to];
+            if (current != NONE && rank(to, current) < r)
+                return REJECTED;
+
+            if (current != NONE)
+            {
+                _partner[current] = NONE;
+                dumped = current;
+            }
+
+            _partner[to] = from;
+            _partner[from] = to;
+            return ACCEPTED;
+        }
+
+    private:
+#ifdef __GNUC__
+        typedef std::tr1::unordered_map < std::string, Index > Lookup;
+#else
+        typedef std::unordered_map < std::string, Index > Lookup;
+#endif
+
+        std::vector<std::string>
+            _ids,
+            _names;
+        std::vector<uint8_t>
+            _side;
+        std::vector<Index>
+            _local,     // position of a member within its side
+            _partner,
+            _next,      // proposal cursor into the preference row
+            _prefs;     // all preference rows, back to back
+        std::vector<std::size_t>
+            _row;       // _prefs[_row[i] .. _row[i + 1]) is the row of i
+        std::vector<Rank>
+            _rank[2];   // per side: _count[side] x _count[other] ranks
+        Index
+            _count[3];
+        Lookup
+            _lookup;
+
+        // The inverse-rank matrix of a side is built on first use, so a run
+        // where only men propose never pays for the men's matrix.
+        std::vector<Rank>& ranks(Side s)
+        {
+            std::vector<Rank> &table = _rank[s];
+            if (!table.empty() || !_count[s])
+                return table;
+
+            Side o = s == MAN ? WOMAN : MAN;
+            table.assign((std::size_t)_count[s] * _count[o], UNRANKED);
+
+            for (Index i = 0; i < count(); i++)
+            {
+                if (side(i) != s)
+                    continue;
+
+                Rank *row = &table[(std::size_t)_local[i] * _count[o]];
+                const Index *p = preferences(i);
+                std::size_t n = countPreferences(i);
+                for (std::size_t k = n; k > 0; k--)
+                    row[_local[p[k - 1]]] = (Rank)(k - 1); // first occurrence wins
+            }
+            return table;
+        }
+    };
+}
+
+#endif
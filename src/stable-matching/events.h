@@ -0,0 +1,175 @@
+#ifndef STABLE_MATCHING_EVENTS_H
+#define STABLE_MATCHING_EVENTS_H
+
+#include <string>
+#include <iostream>
+#include <ostream>
+#include <stdint.h>
+
+#include "engine.h"
+
+namespace stable_matching
+{
+    // Event policies for Relationships and Population.
+    //
+    // Every matching operation reports what happened to its policy, which is
+    // a template parameter, so the choice costs nothing at run time:
+    //
+    //   TraceEvents   the teaching trace on std::cout (the default)
+    //   BinaryEvents  fixed size records written to a binary stream
+    //   NoEvents      nothing at all, every call inlines away
+    //
+    // Relationship events carry the IDs involved, population events carry
+    // engine indices (names can be resolved through the engine).
+
+    class TraceEvents
+    {
+    public:
+        void exist(const std::string &key1, const std::string &key2, bool found)
+        {
+            std::cout << key1 << " -?- " << key2 << " >> " << (found ? "yes" : "no") << std::endl;
+        }
+
+        void is_single(const std::string &key, bool single)
+        {
+            std::cout << "Is {" << key << "} single? " << (!single ? "yes" : "no") << std::endl;
+        }
+
+        void added(const std::string &key1, const std::string &key2, bool done)
+        {
+            if (done)
+                std::cout << key1 << " <-> " << key2 << std::endl;
+            else
+                std::cout << key1 << " -x- " << key2 << " Error creating relationship, are they both single?" << std::endl;
+        }
+
+        void freed(const std::string &key1, const std::string &key2)
+        {
+            std::cout << key1 << " -x- " << key2 << std::endl;
+        }
+
+        // {who} accepted {from}, leaving {dumped} (Engine::NONE if single)
+        void accepted(const Engine &e, Engine::Index who, Engine::Index from, Engine::Index dumped)
+        {
+            (void)from;
+            if (dumped != Engine::NONE)
+                std::cout << e.name(who) << " dumps " << e.name(dumped);
+            else
+                std::cout << e.name(who) << " is single";
+        }
+
+        // {who} rejected {from}, staying with {partner}
+        void rejected(const Engine &e, Engine::Index who, Engine::Index from, Engine::Index partner)
+        {
+            (void)from;
+            std::cout << e.name(who) << " prefers " << e.name(partner);
+        }
+    };
+
+    class NoEvents
+    {
+    public:
+        void exist(const std::string &, const std::string &, bool) {}
+        void is_single(const std::string &, bool) {}
+        void added(const std::string &, const std::string &, bool) {}
+        void freed(const std::string &, const std::string &) {}
+        void accepted(const Engine &, Engine::Index, Engine::Index, Engine::Index) {}
+        void rejected(const Engine &, Engine::Index, Engine::Index, Engine::Index) {}
+    };
+
+    // Writes one 16 byte EventRecord per event (native byte order).
+    // For the relationship events {a} and {b} hold the lengths of the two
+    // IDs, which follow the record as raw bytes.
+    class BinaryEvents
+    {
+    public:
+        enum Type
+        {
+            EXIST = 1,
+            IS_SINGLE = 2,
+            ADDED = 3,
+            FREED = 4,
+            ACCEPTED = 5,
+            REJECTED = 6
+        };
+
+        struct EventRecord
+        {
+            uint8_t type;
+            uint8_t flag;   // result of the operation, if any
+            uint16_t reserved;
+            uint32_t a;
+            uint32_t b;
+            uint32_t c;
+        };
+
+        BinaryEvents() :
+            out(NULL)
+        {};
+
+        BinaryEvents(std::ostream &_out) :
+            out(&_out)
+        {};
+
+        void exist(const std::string &key1, const std::string &key2, bool found)
+        {
+            write(EXIST, found, key1, key2);
+        }
+
+        void is_single(const std::string &key, bool single)
+        {
+            write(IS_SINGLE, single, key, std::string());
+        }
+
+        void added(const std::string &key1, const std::string &key2, bool done)
+        {
+            write(ADDED, done, key1, key2);
+        }
+
+        void freed(const std::string &key1, const std::string &key2)
+        {
+            write(FREED, true, key1, key2);
+        }
+
+        void accepted(const Engine &, Engine::Index who, Engine::Index from, Engine::Index dumped)
+        {
+            write(ACCEPTED, true, who, from, dumped);
+        }
+
+        void rejected(const Engine &, Engine::Index who, Engine::Index from, Engine::Index partner)
+        {
+            write(REJECTED, false, who, from, partner);
+        }
+
+    private:
+        std::ostream
+            *out;
+
+        void write(Type type, bool flag, uint32_t a, uint32_t b, uint32_t c)
+        {
+            if (!out)
+                return;
+
+            EventRecord r;
+            r.type = (uint8_t)type;
+            r.flag = flag ? 1 : 0;
+            r.reserved = 0;
+            r.a = a;
+            r.b = b;
+            r.c = c;
+            out->write((const char*)&r, sizeof(r));
+        }
+
+        void write(Type type, bool flag, const std::string &key1, const std::string &key2)
+        {
+            if (!out)
+                return;
+
+            write(type, flag, (uint32_t)key1.size(), (uint32_t)key2.size(), 0);
+            out->write(key1.data(), key1.size());
+            out->write(key2.data(), key2.size());
+        }
+    };
+}
+
+#endif
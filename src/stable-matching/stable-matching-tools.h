@@ -6,6 +6,7 @@
 
 #include "datastructures.h"
 #include "../common/io.h"
+#include "../common/snapshot.h"
 
 using namespace tools;
 
@@ -33,22 +34,27 @@ namespace stable_matching
             _preferences.clear();
 
             Reader reader(filename);
+            StringView source(reader.file.data(), reader.file.size());
+
+            if (reader.file.is_open() && loadSnapshot(snapshotName(filename), source))
+            {
+                std::cout << "Loaded snapshot [" << snapshotName(filename) << "]" << std::endl;
+                return;
+            }
 
             Mode mode = IGNORE;
-            std::string line;
+            StringView line;
             std::size_t line_id;
             while (reader.getLine(line, line_id))
             {
                 //mode
                 {
-                    std::string line_low = line;
-                    std::transform(line_low.begin(), line_low.end(), line_low.begin(), ::tolower);
-                    if (line_low.compare("[members]") == 0)
+                    if (iequals(line, "[members]"))
                     {
                         mode = MEMBERS;
                         continue;
                     }
-                    if (line_low.compare("[preferences]") == 0)
+                    if (iequals(line, "[preferences]"))
                     {
                         mode = PREFERENCES;
                         continue;
@@ -57,10 +63,10 @@ namespace stable_matching
 
                 if (mode == MEMBERS)
                 {
-                    std::vector<std::string> tokens = tools::split(line, ":");
-                    if (tokens.size() == 2)
+                    StringView tokens[2];
+                    if (tools::split(line, ":", tokens, 2) == 2)
                     {
-                        _members.add(tokens[0], tokens[1]);
+                        _members.add(tokens[0].str(), tokens[1].str());
                     }
                     else
                     {
@@ -71,13 +77,17 @@ namespace stable_matching
 
                 if (mode == PREFERENCES)
                 {
-                    std::vector<std::string> tokens = tools::split(line, ">");
-                    if (tokens.size() == 2)
+                    StringView tokens[2];
+                    if (tools::split(line, ">", tokens, 2) == 2)
                     {
-                        std::vector<std::string> list = tools::split(tokens[1], ",");
+                        std::vector<std::string> list;
+                        Tokenizer ids(tokens[1], ",");
+                        for (Tokenizer::iterator it = ids.begin(); it != ids.end(); ++it)
+                            list.push_back(it->str());
+
                         if (list.size() > 0)
                         {
-                            _preferences.add(tokens[0], list);
+                            _preferences.add(tokens[0].str(), list);
                         }
                         else
                         {
@@ -91,6 +101,9 @@ namespace stable_matching
                     continue;
                 }
             }
+
+            if (reader.file.is_open())
+                saveSnapshot(snapshotName(filename), source);
         }
 
         Members getMembers() { return _members; };
@@ -106,10 +119,79 @@ namespace stable_matching
         };
 
     private:
+        static const uint32_t SNAPSHOT_KIND = 0x54414D53; // "SMAT"
+
         Members
             _members;
         Preferences
             _preferences;
+
+        // payload: members (id, name), then preferences (id, count, ids...)
+        void saveSnapshot(std::string filename, StringView source)
+        {
+            SnapshotWriter snap(SNAPSHOT_KIND);
+
+            snap.put((uint64_t)_members.size());
+            for (Members::iterator it = _members.begin(); it != _members.end(); it++)
+            {
+                snap.put(it->first);
+                snap.put(it->second);
+            }
+
+            snap.put((uint64_t)_preferences.size());
+            for (Preferences::iterator it = _preferences.begin(); it != _preferences.end(); it++)
+            {
+                snap.put(it->first);
+                snap.put((uint64_t)it->second.size());
+                for (unsigned int j = 0; j < it->second.size(); j++)
+                    snap.put(it->second[j]);
+            }
+
+            snap.save(filename, source);
+        }
+
+        bool loadSnapshot(std::string filename, StringView source)
+        {
+            SnapshotReader snap(filename, SNAPSHOT_KIND, source);
+            if (!snap.is_valid())
+                return false;
+
+            uint64_t count = 0;
+            snap.get(count);
+            for (uint64_t j = 0; j < count && snap.is_valid(); j++)
+            {
+                std::string id, name;
+                snap.get(id);
+                snap.get(name);
+                _members.add(id, name);
+            }
+
+            snap.get(count);
+            for (uint64_t j = 0; j < count && snap.is_valid(); j++)
+            {
+                std::string id;
+                uint64_t n = 0;
+                snap.get(id);
+                snap.get(n);
+
+                std::vector<std::string> list;
+                for (uint64_t k = 0; k < n && snap.is_valid(); k++)
+                {
+                    std::string other;
+                    snap.get(other);
+                    list.push_back(other);
+                }
+                _preferences.add(id, list);
+            }
+
+            if (!snap.done())
+            {
+                _members.clear();
+                _preferences.clear();
+                return false;
+            }
+            return true;
+        }
     };
 }
 
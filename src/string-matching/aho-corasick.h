@@ -0,0 +1,323 @@
+#ifndef STRING_MATCHING_AHO_CORASICK_H
+#define STRING_MATCHING_AHO_CORASICK_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include "../common/string.h"
+
+namespace string_matching
+{
+    // Aho-Corasick: all the patterns of a set found in one pass over the text.
+    //
+    // The patterns make a trie; each state is the prefix of some pattern
+    // spelt on the way from the root. Its failure link is what
+    // KMPPrefixTable is for one pattern: the longest proper suffix of that
+    // prefix that is also a state, where the search goes on when the next
+    // character has no edge. Its suffix link skips down the failure links
+    // to the next state where a pattern ends, so reporting the matches
+    // costs one step per match.
+    //
+    // The states are numbered breadth first. Those of depth < DENSE_DEPTH
+    // (the root and its children, the ones nearly every character goes
+    // through) have a full row of 256 transitions with the failures already
+    // followed; deeper ones, which have few edges each, keep only their
+    // edges, sorted by character, in two arrays shared by all the states.
+    class AhoCorasick
+    {
+    public:
+        enum
+        {
+            ROOT = 0,
+            NONE = 0xFFFFFFFF,
+            ALPHABET = 256,
+            DENSE_DEPTH = 2
+        };
+
+        struct Match
+        {
+            unsigned int
+                pattern;    // as numbered by add()
+            std::size_t
+                offset;     // of its first character
+
+            Match(unsigned int _pattern, std::size_t _offset) :
+                pattern(_pattern),
+                offset(_offset)
+            {};
+
+            bool operator==(const Match &m) const { return pattern == m.pattern && offset == m.offset; }
+            bool operator<(const Match &m) const { return offset < m.offset || (offset == m.offset && pattern < m.pattern); }
+        };
+
+        AhoCorasick() :
+            dense(0)
+        {
+            clear();
+        };
+
+        // Adds a pattern and returns its number, from 0. The empty pattern
+        // matches nowhere. build() has to be called again before searching.
+        unsigned int add(tools::StringView pattern)
+        {
+            unsigned int id = (unsigned int)patterns.size();
+            patterns.push_back(pattern.str());
+            built = false;
+            return id;
+        }
+
+        // Builds the automaton of the patterns added so far
+        void build()
+        {
+            Trie trie;
+            trie.nodes.push_back(TrieNode());
+
+            std::vector<unsigned int> terminal(patterns.size(), NONE);
+            for (unsigned int p = 0; p < patterns.size(); p++)
+            {
+                if (patterns[p].empty())
+                    continue;
+
+                unsigned int v = ROOT;
+                for (std::size_t i = 0; i < patterns[p].size(); i++)
+                    v = trie.insert(v, static_cast<unsigned char>(patterns[p][i]));
+                terminal[p] = v;
+            }
+
+            // breadth first order, the new numbers of the trie nodes
+            std::vector<unsigned int> order(1, ROOT), number(trie.nodes.size(), NONE);
+            std::vector<unsigned int> depth(1, 0);
+            number[ROOT] = 0;
+            for (std::size_t k = 0; k < order.size(); k++)
+            {
+                const TrieNode &node = trie.nodes[order[k]];
+                for (std::size_t e = 0; e < node.edges.size(); e++)
+                {
+                    number[node.edges[e].target] = (unsigned int)order.size();
+                    order.push_back(node.edges[e].target);
+                    depth.push_back(depth[k] + 1);
+                }
+            }
+
+            const unsigned int n = (unsigned int)order.size();
+            clear();
+            links.assign(n + 1, State());
+            next.assign(patterns.size(), NONE);
+            length.resize(patterns.size());
+
+            dense = 0;
+            while (dense < n && depth[dense] < DENSE_DEPTH)
+                dense++;
+
+            // the edges of the sparse states, in state order
+            for (unsigned int s = 0; s < n; s++)
+            {
+                links[s].first = (unsigned int)labels.size();
+                if (s < dense)
+                    continue;
+
+                const TrieNode &node = trie.nodes[order[s]];
+                for (std::size_t e = 0; e < node.edges.size(); e++)
+                {
+                    labels.push_back(node.edges[e].label);
+                    targets.push_back(number[node.edges[e].target]);
+                }
+            }
+            links[n].first = (unsigned int)labels.size();
+
+            // a pattern listed twice: both numbers, chained through {next}
+            for (unsigned int p = (unsigned int)patterns.size(); p-- > 0; )
+            {
+                length[p] = (unsigned int)patterns[p].size();
+                if (terminal[p] == NONE)
+                    continue;
+
+                unsigned int s = number[terminal[p]];
+                next[p] = links[s].output;
+                links[s].output = p;
+            }
+
+            // failure and suffix links, parents before children
+            for (unsigned int s = 0; s < n; s++)
+            {
+                const TrieNode &node = trie.nodes[order[s]];
+                for (std::size_t e = 0; e < node.edges.size(); e++)
+                {
+                    unsigned int v = number[node.edges[e].target];
+                    unsigned char c = node.edges[e].label;
+
+                    unsigned int f = ROOT;
+                    if (s != ROOT)
+                    {
+                        f = links[s].fail;
+                        while (f != ROOT && trie.find(order[f], c) == NONE)
+                            f = links[f].fail;
+
+                        unsigned int t = trie.find(order[f], c);
+                        f = t == NONE ? ROOT : number[t];
+                    }
+                    links[v].fail = f;
+                    links[v].suffix = links[f].output != NONE ? f : links[f].suffix;
+                }
+            }
+
+            // the full rows of the dense states, whose failures are dense too
+            table.assign((std::size_t)dense * ALPHABET, ROOT);
+            for (unsigned int s = 0; s < dense; s++)
+            {
+                unsigned int *row = &table[(std::size_t)s * ALPHABET];
+                if (s != ROOT)
+                    std::copy(&table[(std::size_t)links[s].fail * ALPHABET], &table[(std::size_t)links[s].fail * ALPHABET] + ALPHABET, row);
+
+                const TrieNode &node = trie.nodes[order[s]];
+                for (std::size_t e = 0; e < node.edges.size(); e++)
+                    row[node.edges[e].label] = number[node.edges[e].target];
+            }
+
+            built = true;
+        }
+
+        bool isBuilt() const { return built; }
+        std::size_t size() const { return patterns.size(); }
+        const std::string& pattern(unsigned int id) const { return patterns[id]; }
+        unsigned int states() const { return links.empty() ? 0 : (unsigned int)links.size() - 1; }
+
+        // The state after reading {c} in {state}
+        unsigned int step(unsigned int state, unsigned char c) const
+        {
+            while (state >= dense)
+            {
+                const unsigned char *begin = labels.data() + links[state].first, *end = labels.data() + links[state + 1].first;
+                const unsigned char *edge = std::lower_bound(begin, end, c);
+                if (edge != end && *edge == c)
+                    return targets[edge - labels.data()];
+
+                state = links[state].fail;
+            }
+            return table[(std::size_t)state * ALPHABET + c];
+        }
+
+        // Reads {text} from {state} (ROOT for a new text) and appends its
+        // matches to {hits}, by the offset of their last character, then
+        // longest first. {base} is the offset of {text} in the whole text,
+        // so a text can be read in pieces, each from the state the one
+        // before returned.
+        unsigned int scan(unsigned int state, tools::StringView text, std::size_t base, std::vector<Match> &hits) const
+        {
+            if (!built)
+                return state;
+
+            for (std::size_t i = 0; i < text.size(); i++)
+            {
+                state = step(state, static_cast<unsigned char>(text[i]));
+
+                unsigned int s = links[state].output != NONE ? state : links[state].suffix;
+                for (; s != NONE; s = links[s].suffix)
+                {
+                    for (unsigned int p = links[s].output; p != NONE; p = next[p])
+                        hits.push_back(Match(p, base + i + 1 - length[p]));
+                }
+            }
+            return state;
+        }
+
+        void findAll(tools::StringView text, std::vector<Match> &hits) const
+        {
+            scan(ROOT, text, 0, hits);
+        }
+
+    private:
+        // what a search reads of a state, together in 16 bytes
+        struct State
+        {
+            unsigned int
+                first,      // its edges: first .. the first of the next state - 1
+                fail,
+                suffix,     // the nearest state down the failure links with an output
+                output;     // the first pattern ending here, or NONE
+
+            State() :
+                first(0),
+                fail(ROOT),
+                suffix(NONE),
+                output(NONE)
+            {};
+        };
+
+        struct TrieEdge
+        {
+            unsigned char
+                label;
+            unsigned int
+                target;
+
+            bool operator<(unsigned char c) const { return label < c; }
+        };
+
+        struct TrieNode
+        {
+            std::vector<TrieEdge>
+                edges;      // sorted by label
+        };
+
+        // the trie while building, one vector of edges per node
+        struct Trie
+        {
+            std::deque<TrieNode>
+                nodes;
+
+            unsigned int find(unsigned int v, unsigned char c) const
+            {
+                const std::vector<TrieEdge> &edges = nodes[v].edges;
+                std::vector<TrieEdge>::const_iterator e = std::lower_bound(edges.begin(), edges.end(), c);
+                return e != edges.end() && e->label == c ? e->target : (unsigned int)NONE;
+            }
+
+            unsigned int insert(unsigned int v, unsigned char c)
+            {
+                std::vector<TrieEdge> &edges = nodes[v].edges;
+                std::vector<TrieEdge>::iterator e = std::lower_bound(edges.begin(), edges.end(), c);
+                if (e != edges.end() && e->label == c)
+                    return e->target;
+
+                TrieEdge edge;
+                edge.label = c;
+                edge.target = (unsigned int)nodes.size();
+                edges.insert(e, edge);
+                nodes.push_back(TrieNode());
+                return edge.target;
+            }
+        };
+
+        std::vector<std::string>
+            patterns;
+        std::vector<unsigned int>
+            length,     // of each pattern
+            next;       // the next pattern equal to this one, or NONE
+        bool
+            built;
+
+        unsigned int
+            dense;      // states 0 .. dense - 1 have a row in {table}
+        std::vector<unsigned int>
+            table,      // dense * ALPHABET transitions
+            targets;    // of the edges of the sparse states
+        std::vector<unsigned char>
+            labels;     // ... and their characters
+        std::vector<State>
+            links;      // one per state, and one past the last for its {first}
+
+        void clear()
+        {
+            built = false;
+            dense = 0;
+            table.clear();
+            targets.clear();
+            links.clear();
+            labels.clear();
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,247 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <cstdlib>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include "../common/mmap.h"
+#include "compiled-pattern.h"
+#include "simd.h"
+#include "aho-corasick.h"
+#include "parallel.h"
+
+using namespace std;
+using namespace string_matching;
+
+// Compares the exact search engines (naive, KMP, Horspool and the vector
+// filter of simd.h on every instruction set the machine runs) on one text,
+// for patterns of growing length taken from the text itself, and checks
+// that they all find the same matches.
+//
+// Then splits the search for one pattern over 1, 2, 4, ... threads
+// (ParallelSearch, parallel.h).
+//
+// Then searches the text for sets of up to 50000 patterns at once with
+// Aho-Corasick, against one SIMD pass per pattern while that takes under
+// a minute or so.
+//
+// The text is the file given, or {MB} MB of synthetic log lines.
+//
+//   ./string-matching-benchmark [text file | MB = 64] [max threads = hardware threads]
+
+static unsigned int lcg_state = 12345;
+
+// small portable generator, so every platform builds the same text
+static unsigned int next_random(unsigned int n)
+{
+    lcg_state = lcg_state * 1103515245u + 12345u;
+    return (lcg_state >> 8) % n;
+}
+
+static string logLines(size_t size)
+{
+    const char *level[] = { "INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR" };
+    const char *path[] = { "/api/v1/items", "/api/v1/users", "/api/v2/orders", "/static/app.js", "/health" };
+    const char *status[] = { "200 OK", "200 OK", "200 OK", "304 Not Modified", "404 Not Found", "500 Internal Server Error" };
+
+    lcg_state = 12345;
+    string text;
+    text.reserve(size + 256);
+    while (text.size() < size)
+    {
+        stringstream ss;
+        ss << "2016-03-" << setfill('0') << setw(2) << 1 + next_random(28)
+            << " " << setw(2) << next_random(24) << ":" << setw(2) << next_random(60) << ":" << setw(2) << next_random(60)
+            << " " << level[next_random(6)] << " worker-" << next_random(32)
+            << " GET " << path[next_random(5)] << "/" << next_random(100000)
+            << " " << status[next_random(6)] << " in " << next_random(2000) << " ms\n";
+        text += ss.str();
+    }
+    return text;
+}
+
+// runs {algorithm} over {text}, prints the throughput in MB/s
+static size_t run(const CompiledPattern &pattern, tools::StringView text, CompiledPattern::Algorithm algorithm, simd::Engine engine)
+{
+    vector<size_t> offsets;
+
+    clock_t start = clock();
+    if (algorithm == CompiledPattern::SIMD)
+        simd::find(engine, text.data(), text.size(), pattern.str().data(), pattern.size(), offsets);
+    else
+        pattern.findAll(text, offsets, algorithm);
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    cout << setw(11) << fixed << setprecision(0) << (seconds > 0.0 ? text.size() / seconds / 1e6 : 0.0);
+    return offsets.size();
+}
+
+int main(int argc, char *argv[])
+{
+    tools::MappedFile file;
+    string synthetic;
+    tools::StringView text;
+
+    if (argc > 1 && atoi(argv[1]) == 0)
+    {
+        if (!file.open(argv[1]))
+        {
+            cerr << "Error! can't read " << argv[1] << endl;
+            return -1;
+        }
+        text = tools::StringView(file.data(), file.size());
+    }
+    else
+    {
+        int mb = argc > 1 ? atoi(argv[1]) : 64;
+        synthetic = logLines((size_t)mb << 20);
+        text = synthetic;
+    }
+
+    cout << "Text: " << text.size() / 1e6 << " MB, throughput in MB/s" << endl << endl;
+
+    cout << setw(6) << "m" << setw(11) << "naive" << setw(11) << "kmp" << setw(11) << "horspool";
+    for (int e = simd::SCALAR; e < simd::BEST; e++)
+    {
+        if (simd::supported((simd::Engine)e))
+            cout << setw(11) << simd::name((simd::Engine)e);
+    }
+    cout << setw(10) << "matches" << endl;
+
+    for (size_t m = 1; m <= 64 && m <= text.size(); m *= 2)
+    {
+        // a pattern that occurs: the one starting a third of the way in
+        CompiledPattern pattern(text.substr(text.size() / 3, m));
+
+        cout << setw(6) << m;
+        size_t count = run(pattern, text, CompiledPattern::NAIVE, simd::SCALAR);
+        bool same = true;
+        same &= run(pattern, text, CompiledPattern::KMP, simd::SCALAR) == count;
+        same &= run(pattern, text, CompiledPattern::HORSPOOL, simd::SCALAR) == count;
+        for (int e = simd::SCALAR; e < simd::BEST; e++)
+        {
+            if (simd::supported((simd::Engine)e))
+                same &= run(pattern, text, CompiledPattern::SIMD, (simd::Engine)e) == count;
+        }
+        cout << setw(10) << count;
+        if (!same)
+            cout << "  MISMATCH";
+        cout << endl;
+    }
+
+    unsigned int max_threads = argc > 2 ? atoi(argv[2]) : std::thread::hardware_concurrency();
+    if (max_threads == 0)
+        max_threads = 1;
+
+    cout << endl << setw(9) << "threads";
+    const char *names[] = { "kmp", "horspool", "simd" };
+    const CompiledPattern::Algorithm algorithms[] = { CompiledPattern::KMP, CompiledPattern::HORSPOOL, CompiledPattern::SIMD };
+    for (int a = 0; a < 3; a++)
+        cout << setw(11) << names[a] << setw(9) << "speedup";
+    cout << setw(10) << "matches" << endl;
+
+    CompiledPattern pattern(text.substr(text.size() / 3, min<size_t>(16, text.size())));
+    size_t count = pattern.findAll(text).size();
+    double single[3] = { 0.0, 0.0, 0.0 };
+    for (unsigned int threads = 1; ; threads *= 2)
+    {
+        if (threads > max_threads)
+            threads = max_threads;
+
+        ParallelSearch search(threads);
+        cout << setw(9) << search.threads();
+        bool same = true;
+        for (int a = 0; a < 3; a++)
+        {
+            // wall time: clock() would add up the time of every thread
+            vector<size_t> offsets;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            search.findAll(pattern, text, offsets, algorithms[a]);
+            chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+
+            if (threads == 1)
+                single[a] = seconds.count();
+            same &= offsets.size() == count;
+            cout << setw(11) << setprecision(0) << (seconds.count() > 0.0 ? text.size() / seconds.count() / 1e6 : 0.0)
+                << setw(9) << setprecision(2) << (seconds.count() > 0.0 ? single[a] / seconds.count() : 0.0);
+        }
+        cout << setw(10) << count;
+        if (!same)
+            cout << "  MISMATCH";
+        cout << endl;
+
+        if (threads == max_threads)
+            break;
+    }
+
+    cout << endl
+        << setw(9) << "patterns"
+        << setw(10) << "states"
+        << setw(11) << "build s"
+        << setw(11) << "a-c MB/s"
+        << setw(11) << "simd MB/s"
+        << setw(10) << "matches" << endl;
+
+    for (size_t count = 10; count <= 50000; count *= count < 10000 ? 10 : 5)
+    {
+        // patterns of 16 to 40 bytes from all over the text
+        lcg_state = 54321;
+        AhoCorasick automaton;
+        vector<CompiledPattern> patterns;
+        for (size_t k = 0; k < count; k++)
+        {
+            size_t m = 16 + next_random(25);
+            if (m > text.size())
+                break;
+            size_t offset = (size_t)(((unsigned long long)next_random(1u << 24) << 24 | next_random(1u << 24)) % (text.size() - m + 1));
+            automaton.add(text.substr(offset, m));
+            if (count <= 1000)
+                patterns.push_back(CompiledPattern(text.substr(offset, m)));
+        }
+
+        clock_t start = clock();
+        automaton.build();
+        double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        // a megabyte at a time, so the matches are counted, not all kept
+        vector<AhoCorasick::Match> hits;
+        size_t matches = 0;
+        unsigned int state = AhoCorasick::ROOT;
+        start = clock();
+        for (size_t offset = 0; offset < text.size(); offset += 1 << 20)
+        {
+            hits.clear();
+            state = automaton.scan(state, text.substr(offset, 1 << 20), offset, hits);
+            matches += hits.size();
+        }
+        double scan = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        cout << setw(9) << count << setw(10) << automaton.states()
+            << setw(11) << setprecision(3) << seconds
+            << setw(11) << setprecision(0) << (scan > 0.0 ? text.size() / scan / 1e6 : 0.0);
+
+        if (patterns.empty())
+            cout << setw(11) << "-";
+        else
+        {
+            size_t total = 0;
+            vector<size_t> offsets;
+            start = clock();
+            for (size_t k = 0; k < patterns.size(); k++)
+            {
+                offsets.clear();
+                patterns[k].findAll(text, offsets, CompiledPattern::SIMD);
+                total += offsets.size();
+            }
+            double simd = (double)(clock() - start) / CLOCKS_PER_SEC;
+            cout << setw(11) << (simd > 0.0 ? text.size() / simd / 1e6 : 0.0);
+            if (total != matches)
+                cout << "  MISMATCH: " << total;
+        }
+        cout << setw(10) << matches << endl;
+    }
+
+    return 0;
+}
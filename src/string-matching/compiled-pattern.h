@@ -0,0 +1,126 @@
+#ifndef STRING_MATCHING_COMPILED_PATTERN_H
+#define STRING_MATCHING_COMPILED_PATTERN_H
+
+#include <string>
+#include <vector>
+#include "../common/string.h"
+#include "string-matching-tools.h"
+#include "simd.h"
+
+namespace string_matching
+{
+    // A pattern with its KMP prefix table and Horspool shift table, built
+    // once. Searching does not change it, so one CompiledPattern can serve
+    // any number of searches, from any number of threads.
+    class CompiledPattern
+    {
+    public:
+        enum Algorithm
+        {
+            NAIVE,      // every offset compared in full, O(n m)
+            KMP,        // O(n + m), whatever the text
+            HORSPOOL,   // sublinear on average, O(n m) at worst
+            SIMD        // simd::find() with the widest engine there is
+        };
+
+        CompiledPattern(tools::StringView pattern) :
+            _pattern(pattern.str()),
+            _prefix(pattern),
+            _shift(pattern)
+        {};
+
+        const std::string& str() const { return _pattern; }
+        std::size_t size() const { return _pattern.size(); }
+
+        const KMPPrefixTable& prefixTable() const { return _prefix; }
+        const BMHTable& shiftTable() const { return _shift; }
+
+        // Appends to {offsets} the offset of every match in {text}, in
+        // increasing order, overlapping ones included. The empty pattern
+        // matches nowhere.
+        void findAll(tools::StringView text, std::vector<std::size_t> &offsets, Algorithm algorithm = KMP) const
+        {
+            if (_pattern.empty() || text.size() < _pattern.size())
+                return;
+
+            switch (algorithm)
+            {
+            case NAIVE: naive(text, offsets); break;
+            case HORSPOOL: horspool(text, offsets); break;
+            case SIMD: simd::find(simd::BEST, text.data(), text.size(), _pattern.data(), _pattern.size(), offsets); break;
+            default: kmp(text, offsets); break;
+            }
+        }
+
+        std::vector<std::size_t> findAll(tools::StringView text, Algorithm algorithm = KMP) const
+        {
+            std::vector<std::size_t> offsets;
+            findAll(text, offsets, algorithm);
+            return offsets;
+        }
+
+    private:
+        std::string
+            _pattern;
+        KMPPrefixTable
+            _prefix;
+        BMHTable
+            _shift;
+
+        void naive(tools::StringView text, std::vector<std::size_t> &offsets) const
+        {
+            const std::size_t n = text.size(), m = _pattern.size();
+            for (std::size_t offset = 0; offset + m <= n; offset++)
+            {
+                std::size_t i = 0;
+                while (i < m && text[offset + i] == _pattern[i])
+                    i++;
+
+                if (i == m)
+                    offsets.push_back(offset);
+            }
+        }
+
+        void kmp(tools::StringView text, std::vector<std::size_t> &offsets) const
+        {
+            const std::size_t m = _pattern.size();
+            std::size_t i = 0;
+            for (std::size_t j = 0; j < text.size(); j++)
+            {
+                while (i > 0 && _pattern[i] != text[j])
+                    i = _prefix[i];
+
+                if (_pattern[i] == text[j])
+                    i++;
+
+                if (i == m)
+                {
+                    offsets.push_back(j + 1 - m);
+                    i = _prefix[m];
+                }
+            }
+        }
+
+        void horspool(tools::StringView text, std::vector<std::size_t> &offsets) const
+        {
+            const std::size_t n = text.size(), m = _pattern.size();
+            const char *p = _pattern.data();
+            for (std::size_t offset = 0; offset + m <= n; )
+            {
+                const char last = text[offset + m - 1];
+                if (last == p[m - 1])
+                {
+                    std::size_t i = m - 1;
+                    while (i > 0 && p[i - 1] == text[offset + i - 1])
+                        i--;
+
+                    if (i == 0)
+                        offsets.push_back(offset);
+                }
+                offset += _shift[static_cast<unsigned char>(last)];
+            }
+        }
+    };
+}
+
+#endif
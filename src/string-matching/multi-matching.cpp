@@ -0,0 +1,52 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../common/io.h"
+#include "aho-corasick.h"
+
+using namespace std;
+using namespace string_matching;
+
+// Finds every pattern of a set in one text, in one pass (Aho-Corasick).
+// The pattern file has one pattern per line ('#' comments and blank lines
+// are skipped, the patterns are trimmed); the text is any file, read as is.
+// Prints one line per match: offset, pattern number (from 1) and pattern.
+//
+//   ./multi-matching patterns.txt text.txt
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        cerr << "Error! you need to include the pattern file and the text file in the command line" << endl;
+        return -1;
+    }
+
+    AhoCorasick automaton;
+    {
+        tools::Reader reader(argv[1]);
+        tools::StringView line;
+        size_t line_id;
+        while (reader.getLine(line, line_id))
+            automaton.add(line);
+    }
+    automaton.build();
+
+    tools::MappedFile text(argv[2]);
+    if (!text.is_open())
+    {
+        cerr << "Error! can't read " << argv[2] << endl;
+        return -1;
+    }
+
+    vector<AhoCorasick::Match> hits;
+    automaton.findAll(tools::StringView(text.data(), text.size()), hits);
+
+    for (size_t i = 0; i < hits.size(); i++)
+        cout << hits[i].offset << "\t#" << hits[i].pattern + 1 << "\t" << automaton.pattern(hits[i].pattern) << "\n";
+
+    cout << hits.size() << " matches of " << automaton.size() << " patterns ("
+        << automaton.states() << " states) in " << text.size() << " bytes" << endl;
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <chrono>
+
+#include "../common/mmap.h"
+#include "../common/string.h"
+#include "parallel.h"
+
+using namespace std;
+using namespace string_matching;
+
+// Searches a whole file, memory mapped, for one pattern on several threads.
+// Prints the offset of every match, then how many there were and how fast.
+//
+//   ./parallel-matching pattern file [threads = hardware threads] [naive | kmp | horspool | simd = kmp]
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        cerr << "Error! you need to include the pattern and the file in the command line" << endl;
+        return -1;
+    }
+
+    unsigned int threads = argc > 3 ? atoi(argv[3]) : 0;
+
+    CompiledPattern::Algorithm algorithm = CompiledPattern::KMP;
+    if (argc > 4)
+    {
+        const char *names[] = { "naive", "kmp", "horspool", "simd" };
+        int a = 0;
+        while (a < 4 && !tools::iequals(argv[4], names[a]))
+            a++;
+        if (a == 4)
+        {
+            cerr << "Error! unknown algorithm " << argv[4] << endl;
+            return -1;
+        }
+        algorithm = (CompiledPattern::Algorithm)a;
+    }
+
+    tools::MappedFile file(argv[2]);
+    if (!file.is_open())
+    {
+        cerr << "Error! can't read " << argv[2] << endl;
+        return -1;
+    }
+
+    CompiledPattern pattern(argv[1]);
+    ParallelSearch search(threads);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<size_t> offsets;
+    search.findAll(pattern, tools::StringView(file.data(), file.size()), offsets, algorithm);
+    chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+
+    for (size_t k = 0; k < offsets.size(); k++)
+        cout << offsets[k] << "\n";
+
+    cout << offsets.size() << " matches in " << file.size() << " bytes on " << search.threads() << " threads, "
+        << fixed << setprecision(0) << (seconds.count() > 0.0 ? file.size() / seconds.count() / 1e6 : 0.0) << " MB/s" << endl;
+
+    return 0;
+}
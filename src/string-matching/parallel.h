@@ -0,0 +1,124 @@
+#ifndef STRING_MATCHING_PARALLEL_H
+#define STRING_MATCHING_PARALLEL_H
+
+#include <vector>
+#include <algorithm>
+#include "../common/string.h"
+#include "../common/thread-pool.h"
+#include "compiled-pattern.h"
+
+namespace string_matching
+{
+    // A CompiledPattern searched by several threads at once, one part of
+    // the text each (a tools::ThreadPool job), with any of its algorithms.
+    //
+    // Each part owns the matches that start in a contiguous range of
+    // offsets [begin, end), and searches text[begin, end + m - 1): the m - 1
+    // bytes it shares with the next part are just enough to finish the
+    // matches that start before {end}, and too few to hold one that starts
+    // at {end} or later. So a match at a seam is found by exactly one part,
+    // and the parts, taken in order, give the offsets already sorted.
+    //
+    // The text can be anything in memory: a string, or a tools::MappedFile
+    // for a whole file.
+    //
+    // Needs C++11 (-std=c++11 -pthread with GCC).
+    class ParallelSearch
+    {
+    public:
+        enum
+        {
+            MIN_PART = 1 << 16  // smaller texts are not worth splitting
+        };
+
+        // {threads} counts the calling thread; 0 means one per hardware thread
+        ParallelSearch(unsigned int threads = 0) :
+            pool(threads)
+        {};
+
+        unsigned int threads() const { return pool.size(); }
+
+        // Appends to {offsets} the offset of every match in {text}, in
+        // increasing order, as CompiledPattern::findAll()
+        void findAll(const CompiledPattern &pattern, tools::StringView text, std::vector<std::size_t> &offsets,
+            CompiledPattern::Algorithm algorithm = CompiledPattern::KMP)
+        {
+            if (pattern.size() == 0 || text.size() < pattern.size())
+                return;
+
+            Search search(pattern, text, algorithm, pool.size());
+            if (search.parts() == 1)
+            {
+                pattern.findAll(text, offsets, algorithm);
+                return;
+            }
+
+            pool.run(search);
+
+            for (unsigned int part = 0; part < search.parts(); part++)
+                offsets.insert(offsets.end(), search.found[part].begin(), search.found[part].end());
+        }
+
+        std::vector<std::size_t> findAll(const CompiledPattern &pattern, tools::StringView text,
+            CompiledPattern::Algorithm algorithm = CompiledPattern::KMP)
+        {
+            std::vector<std::size_t> offsets;
+            findAll(pattern, text, offsets, algorithm);
+            return offsets;
+        }
+
+    private:
+        class Search :
+            public tools::ThreadPool::Job
+        {
+        public:
+            std::vector< std::vector<std::size_t> >
+                found;      // per part
+
+            Search(const CompiledPattern &_pattern, tools::StringView _text, CompiledPattern::Algorithm _algorithm, unsigned int threads) :
+                pattern(_pattern),
+                text(_text),
+                algorithm(_algorithm),
+                starts(_text.size() - _pattern.size() + 1)
+            {
+                unsigned int n = (unsigned int)std::min<std::size_t>(threads, (starts + MIN_PART - 1) / MIN_PART);
+                found.resize(n ? n : 1);
+            }
+
+            unsigned int parts() const { return (unsigned int)found.size(); }
+
+            void run(unsigned int part, unsigned int)
+            {
+                if (part >= parts())
+                    return;
+
+                std::size_t
+                    begin = (std::size_t)((unsigned long long)starts * part / parts()),
+                    end = (std::size_t)((unsigned long long)starts * (part + 1) / parts());
+
+                // the matches starting in [begin, end), and no others; kept
+                // apart until the end, the vectors of the parts share cache lines
+                std::vector<std::size_t> offsets;
+                pattern.findAll(text.substr(begin, end - begin + pattern.size() - 1), offsets, algorithm);
+                for (std::size_t k = 0; k < offsets.size(); k++)
+                    offsets[k] += begin;
+                found[part].swap(offsets);
+            }
+
+        private:
+            const CompiledPattern
+                &pattern;
+            tools::StringView
+                text;
+            CompiledPattern::Algorithm
+                algorithm;
+            std::size_t
+                starts;     // offsets where a match could start
+        };
+
+        tools::ThreadPool
+            pool;
+    };
+}
+
+#endif
@@ -0,0 +1,226 @@
+#ifndef STRING_MATCHING_SIMD_H
+#define STRING_MATCHING_SIMD_H
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// Vector exact search, picked at run time: each engine compares a block of
+// text (16, 32 or 64 bytes) with the first byte of the pattern and the
+// block m - 1 bytes further with its last byte, and only the offsets where
+// both match are compared in full. On ordinary text few offsets pass both,
+// so most of the text is only ever seen a block at a time.
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#define STRING_MATCHING_TARGET(isa)
+#define STRING_MATCHING_SSE2
+#define STRING_MATCHING_AVX
+#elif (defined(__x86_64__) || defined(__i386__)) && (defined(__clang__) || __GNUC__ >= 5)
+#include <immintrin.h>
+#define STRING_MATCHING_TARGET(isa) __attribute__((target(isa)))
+#define STRING_MATCHING_SSE2
+#define STRING_MATCHING_AVX
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define STRING_MATCHING_TARGET(isa)
+#define STRING_MATCHING_SSE2
+#endif
+
+namespace string_matching
+{
+    namespace simd
+    {
+        enum Engine
+        {
+            SCALAR,
+            SSE2,
+            AVX2,
+            AVX512,     // AVX-512BW, the byte compares
+            BEST        // the widest one this machine runs
+        };
+
+        inline const char* name(Engine e)
+        {
+            switch (e)
+            {
+            case SCALAR: return "scalar";
+            case SSE2: return "sse2";
+            case AVX2: return "avx2";
+            case AVX512: return "avx512bw";
+            default: return "best";
+            }
+        }
+
+        inline bool supported(Engine e)
+        {
+            switch (e)
+            {
+            case SCALAR:
+                return true;
+#if defined(STRING_MATCHING_SSE2)
+            case SSE2:
+                return true;    // part of every x86-64, assumed on x86
+#endif
+#if defined(STRING_MATCHING_AVX) && defined(_MSC_VER)
+            case AVX2:
+            case AVX512:
+            {
+                int info[4];
+                __cpuid(info, 1);
+                bool osxsave = (info[2] & (1 << 27)) != 0;
+                if (!osxsave)
+                    return false;
+
+                unsigned long long xcr0 = _xgetbv(0);
+                __cpuidex(info, 7, 0);
+                if (e == AVX2)
+                    return (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+                return (xcr0 & 0xE6) == 0xE6 && (info[1] & (1 << 30)) != 0;
+            }
+#elif defined(STRING_MATCHING_AVX)
+            case AVX2:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx2") != 0;
+            case AVX512:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx512bw") != 0;
+#endif
+            default:
+                return false;
+            }
+        }
+
+        inline Engine best()
+        {
+            static Engine e = supported(AVX512) ? AVX512 : (supported(AVX2) ? AVX2 : (supported(SSE2) ? SSE2 : SCALAR));
+            return e;
+        }
+
+        // Index of the lowest set bit of {mask} (not 0)
+        inline unsigned int lowest(unsigned long long mask)
+        {
+#if defined(_MSC_VER)
+            unsigned long i;
+#if defined(_M_X64)
+            _BitScanForward64(&i, mask);
+#else
+            if (!_BitScanForward(&i, (unsigned long)mask))
+            {
+                _BitScanForward(&i, (unsigned long)(mask >> 32));
+                i += 32;
+            }
+#endif
+            return i;
+#else
+            return __builtin_ctzll(mask);
+#endif
+        }
+
+        // Appends the offsets of the candidates in {mask} (bit k: offset
+        // {base} + k) that match the whole pattern
+        inline void verify(unsigned long long mask, const char *text, std::size_t base,
+            const char *pattern, std::size_t m, std::vector<std::size_t> &offsets)
+        {
+            while (mask)
+            {
+                std::size_t offset = base + lowest(mask);
+                if (m <= 2 || std::memcmp(text + offset + 1, pattern + 1, m - 2) == 0)
+                    offsets.push_back(offset);
+                mask &= mask - 1;
+            }
+        }
+
+        // Candidates from offset {from} on, one at a time
+        inline void findScalar(const char *text, std::size_t n, const char *pattern, std::size_t m,
+            std::vector<std::size_t> &offsets, std::size_t from = 0)
+        {
+            const char first = pattern[0], last = pattern[m - 1];
+            for (std::size_t offset = from; offset + m <= n; offset++)
+            {
+                if (text[offset] == first && text[offset + m - 1] == last &&
+                    (m <= 2 || std::memcmp(text + offset + 1, pattern + 1, m - 2) == 0))
+                    offsets.push_back(offset);
+            }
+        }
+
+#if defined(STRING_MATCHING_SSE2)
+        STRING_MATCHING_TARGET("sse2")
+        inline void findSSE2(const char *text, std::size_t n, const char *pattern, std::size_t m,
+            std::vector<std::size_t> &offsets)
+        {
+            const __m128i first = _mm_set1_epi8(pattern[0]), last = _mm_set1_epi8(pattern[m - 1]);
+            std::size_t offset = 0;
+            for (; offset + m - 1 + 16 <= n; offset += 16)
+            {
+                __m128i a = _mm_cmpeq_epi8(first, _mm_loadu_si128((const __m128i*)(text + offset)));
+                __m128i b = _mm_cmpeq_epi8(last, _mm_loadu_si128((const __m128i*)(text + offset + m - 1)));
+                unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(a, b));
+                verify(mask, text, offset, pattern, m, offsets);
+            }
+            findScalar(text, n, pattern, m, offsets, offset);
+        }
+#endif
+
+#if defined(STRING_MATCHING_AVX)
+        STRING_MATCHING_TARGET("avx2")
+        inline void findAVX2(const char *text, std::size_t n, const char *pattern, std::size_t m,
+            std::vector<std::size_t> &offsets)
+        {
+            const __m256i first = _mm256_set1_epi8(pattern[0]), last = _mm256_set1_epi8(pattern[m - 1]);
+            std::size_t offset = 0;
+            for (; offset + m - 1 + 32 <= n; offset += 32)
+            {
+                __m256i a = _mm256_cmpeq_epi8(first, _mm256_loadu_si256((const __m256i*)(text + offset)));
+                __m256i b = _mm256_cmpeq_epi8(last, _mm256_loadu_si256((const __m256i*)(text + offset + m - 1)));
+                unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(a, b));
+                verify(mask, text, offset, pattern, m, offsets);
+            }
+            findScalar(text, n, pattern, m, offsets, offset);
+        }
+
+        STRING_MATCHING_TARGET("avx512f,avx512bw")
+        inline void findAVX512(const char *text, std::size_t n, const char *pattern, std::size_t m,
+            std::vector<std::size_t> &offsets)
+        {
+            const __m512i first = _mm512_set1_epi8(pattern[0]), last = _mm512_set1_epi8(pattern[m - 1]);
+            std::size_t offset = 0;
+            for (; offset + m - 1 + 64 <= n; offset += 64)
+            {
+                __mmask64 a = _mm512_cmpeq_epi8_mask(first, _mm512_loadu_si512((const void*)(text + offset)));
+                __mmask64 b = _mm512_cmpeq_epi8_mask(last, _mm512_loadu_si512((const void*)(text + offset + m - 1)));
+                verify((unsigned long long)(a & b), text, offset, pattern, m, offsets);
+            }
+            findScalar(text, n, pattern, m, offsets, offset);
+        }
+#endif
+
+        // Appends to {offsets} the offset of every match of {pattern} in
+        // {text}, in increasing order, overlapping ones included; {e} must be
+        // supported() or BEST
+        inline void find(Engine e, const char *text, std::size_t n, const char *pattern, std::size_t m,
+            std::vector<std::size_t> &offsets)
+        {
+            if (m == 0 || n < m)
+                return;
+
+            if (e == BEST)
+                e = best();
+
+            switch (e)
+            {
+#if defined(STRING_MATCHING_AVX)
+            case AVX512: findAVX512(text, n, pattern, m, offsets); break;
+            case AVX2: findAVX2(text, n, pattern, m, offsets); break;
+#endif
+#if defined(STRING_MATCHING_SSE2)
+            case SSE2: findSSE2(text, n, pattern, m, offsets); break;
+#endif
+            default: findScalar(text, n, pattern, m, offsets); break;
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <chrono>
+
+#include "../common/string.h"
+#include "stream.h"
+
+using namespace std;
+using namespace string_matching;
+
+// Searches a file of any size for one pattern, a chunk at a time, so the
+// file never has to fit in memory. Prints the offset of every match, then
+// how many there were and how fast.
+//
+//   ./stream-matching pattern file [naive | kmp | horspool | simd = kmp] [chunk KB = 4096]
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        cerr << "Error! you need to include the pattern and the file in the command line" << endl;
+        return -1;
+    }
+
+    CompiledPattern::Algorithm algorithm = CompiledPattern::KMP;
+    if (argc > 3)
+    {
+        const char *names[] = { "naive", "kmp", "horspool", "simd" };
+        int a = 0;
+        while (a < 4 && !tools::iequals(argv[3], names[a]))
+            a++;
+        if (a == 4)
+        {
+            cerr << "Error! unknown algorithm " << argv[3] << endl;
+            return -1;
+        }
+        algorithm = (CompiledPattern::Algorithm)a;
+    }
+    size_t chunk = argc > 4 ? (size_t)atoi(argv[4]) << 10 : (size_t)ChunkReader::DEFAULT_CHUNK;
+
+    ChunkReader reader(argv[2], chunk);
+    if (!reader.is_open())
+    {
+        cerr << "Error! can't read " << argv[2] << endl;
+        return -1;
+    }
+
+    CompiledPattern pattern(argv[1]);
+    StreamSearch search(pattern, algorithm);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    size_t matches = 0;
+    vector<size_t> offsets;
+    tools::StringView piece;
+    while (reader.next(piece))
+    {
+        offsets.clear();
+        search.feed(piece, offsets);
+        for (size_t k = 0; k < offsets.size(); k++)
+            cout << offsets[k] << "\n";
+        matches += offsets.size();
+    }
+    chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+
+    cout << matches << " matches in " << search.position() << " bytes, "
+        << fixed << setprecision(0) << (seconds.count() > 0.0 ? search.position() / seconds.count() / 1e6 : 0.0) << " MB/s" << endl;
+
+    return 0;
+}
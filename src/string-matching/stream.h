@@ -0,0 +1,220 @@
+#ifndef STRING_MATCHING_STREAM_H
+#define STRING_MATCHING_STREAM_H
+
+#include <cstdio>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <thread>
+#include "../common/string.h"
+#include "compiled-pattern.h"
+
+namespace string_matching
+{
+    // Reads a file of any size in chunks of a fixed size, double buffered:
+    // while the caller searches one chunk, a second thread reads the next
+    // one into the other buffer. Memory use is two chunks, whatever the
+    // size of the file.
+    //
+    // Needs C++11 (-std=c++11 -pthread with GCC).
+    class ChunkReader
+    {
+    public:
+        enum
+        {
+            DEFAULT_CHUNK = 1 << 22     // 4 MB
+        };
+
+        ChunkReader(const std::string &filename, std::size_t chunk = DEFAULT_CHUNK) :
+            _file(std::fopen(filename.c_str(), "rb")),
+            _chunk(chunk ? chunk : (std::size_t)DEFAULT_CHUNK),
+            _current(_chunk),
+            _next(_chunk),
+            _length(0),
+            _offset(0),
+            _read(0)
+        {
+            if (!_file)
+                return;
+
+            // the chunks are already large, the stdio buffer would only copy them
+            std::setvbuf(_file, NULL, _IONBF, 0);
+            _reader = std::thread(&ChunkReader::fill, this);
+        };
+
+        ~ChunkReader()
+        {
+            if (_reader.joinable())
+                _reader.join();
+            if (_file)
+                std::fclose(_file);
+        };
+
+        bool is_open() const { return _file != NULL; }
+        std::size_t chunkSize() const { return _chunk; }
+
+        // The next chunk, false at the end of the file. It stays valid until
+        // the next call.
+        bool next(tools::StringView &chunk)
+        {
+            if (!_reader.joinable())
+                return false;
+
+            _reader.join();
+            _current.swap(_next);
+            _offset += _length;
+            _length = _read;
+            if (_length == 0)
+                return false;
+
+            _reader = std::thread(&ChunkReader::fill, this);
+            chunk = tools::StringView(&_current[0], _length);
+            return true;
+        }
+
+        // of the last chunk returned by next() in the file
+        std::size_t offset() const { return _offset; }
+
+    private:
+        std::FILE
+            *_file;
+        std::size_t
+            _chunk;
+        std::vector<char>
+            _current,
+            _next;      // filled by {_reader}
+        std::size_t
+            _length,    // of {_current}
+            _offset,
+            _read;      // into {_next}
+        std::thread
+            _reader;
+
+        ChunkReader(const ChunkReader &);
+        ChunkReader& operator=(const ChunkReader &);
+
+        void fill()
+        {
+            _read = 0;
+            while (_read < _chunk)
+            {
+                std::size_t n = std::fread(&_next[_read], 1, _chunk - _read, _file);
+                if (n == 0)
+                    break;
+                _read += n;
+            }
+        }
+    };
+
+    // A CompiledPattern searched over a text that comes in pieces (e.g. the
+    // chunks of a ChunkReader), with each match reported once, at its
+    // offset in the whole text, wherever the pieces were cut.
+    //
+    // KMP carries its state over, the length of the pattern prefix matched
+    // so far. The other algorithms keep the last m - 1 bytes read: a match
+    // that starts there and ends in the next piece is found in those bytes
+    // followed by the first m - 1 of the piece, and one that fits in the
+    // piece is found in the piece itself, so memory use is bounded by the
+    // pattern, not the text.
+    class StreamSearch
+    {
+    public:
+        StreamSearch(const CompiledPattern &pattern, CompiledPattern::Algorithm algorithm = CompiledPattern::KMP) :
+            _pattern(pattern),
+            _algorithm(algorithm),
+            _matched(0),
+            _position(0)
+        {};
+
+        // Starts a new text
+        void reset()
+        {
+            _matched = 0;
+            _position = 0;
+            _tail.clear();
+        }
+
+        // bytes read so far
+        std::size_t position() const { return _position; }
+
+        // Reads the next piece of the text and appends the offsets of the
+        // matches that end in it to {offsets}, in increasing order
+        void feed(tools::StringView piece, std::vector<std::size_t> &offsets)
+        {
+            const std::size_t m = _pattern.size();
+            if (m == 0)
+                return;
+
+            if (_algorithm == CompiledPattern::KMP)
+                kmp(piece, offsets);
+            else
+            {
+                if (!_tail.empty())
+                {
+                    // across the cut: the tail and the start of the piece
+                    std::string seam = _tail;
+                    seam.append(piece.data(), std::min(piece.size(), m - 1));
+
+                    std::size_t first = offsets.size();
+                    _pattern.findAll(seam, offsets, _algorithm);
+                    for (std::size_t k = first; k < offsets.size(); k++)
+                        offsets[k] += _position - _tail.size();
+                }
+
+                std::size_t first = offsets.size();
+                _pattern.findAll(piece, offsets, _algorithm);
+                for (std::size_t k = first; k < offsets.size(); k++)
+                    offsets[k] += _position;
+
+                // the last m - 1 bytes, across this piece and the ones before
+                if (piece.size() >= m - 1)
+                    _tail.assign(piece.data() + piece.size() - (m - 1), m - 1);
+                else
+                {
+                    _tail.append(piece.data(), piece.size());
+                    if (_tail.size() > m - 1)
+                        _tail.erase(0, _tail.size() - (m - 1));
+                }
+            }
+
+            _position += piece.size();
+        }
+
+    private:
+        const CompiledPattern
+            &_pattern;
+        CompiledPattern::Algorithm
+            _algorithm;
+        std::size_t
+            _matched,   // KMP: pattern characters matched at the end of the text so far
+            _position;
+        std::string
+            _tail;      // the others: the last m - 1 bytes of the text so far
+
+        void kmp(tools::StringView piece, std::vector<std::size_t> &offsets)
+        {
+            const std::string &p = _pattern.str();
+            const KMPPrefixTable &prefix = _pattern.prefixTable();
+            const std::size_t m = p.size();
+
+            std::size_t i = _matched;
+            for (std::size_t j = 0; j < piece.size(); j++)
+            {
+                while (i > 0 && p[i] != piece[j])
+                    i = prefix[i];
+
+                if (p[i] == piece[j])
+                    i++;
+
+                if (i == m)
+                {
+                    offsets.push_back(_position + j + 1 - m);
+                    i = prefix[m];
+                }
+            }
+            _matched = i;
+        }
+    };
+}
+
+#endif
@@ -8,74 +8,52 @@
 namespace string_matching
 {
 
+    // table[l]: the length of the longest proper prefix of pattern[0, l)
+    // that is also a suffix of it (its border), for l = 0 .. m. Each one is
+    // found from the borders of the shorter prefixes, O(m) in all.
     class KMPPrefixTable :
         public std::vector < unsigned int >
     {
     public:
 
-        KMPPrefixTable(std::string pattern) :
-            std::vector < unsigned int >(pattern.size() + 1)
+        KMPPrefixTable(tools::StringView pattern) :
+            std::vector < unsigned int >(pattern.size() + 1, 0)
         {
-            if (pattern.size() == 0)
+            unsigned int k = 0;
+            for (unsigned int l = 1; l < pattern.size(); l++)
             {
-                at(0) = 0;
-                return;
-            }
-
-            for (unsigned int l = 1; l < size(); l++)
-            {
-                std::string sub = pattern.substr(0, l);
-
-                unsigned int max = 0, iteration = 0;
-                std::string::iterator it = sub.begin();
-                it++;
-                for (; it != sub.end(); it++)
-                {
-                	std::string::iterator target = it;
-                	std::string::iterator origin = sub.begin();
-
-                    unsigned int count = 0;
-                    while (target != sub.end() && origin != it)
-                    {
-                        if (*origin != *target)
-                        {
-                            break;
-                        }
+                while (k > 0 && pattern[l] != pattern[k])
+                    k = at(k);
 
-                        count++;
-                        target++;
-                        origin++;
-                    }
+                if (pattern[l] == pattern[k])
+                    k++;
 
-                    if (count == sub.size() - iteration - 1 && count > max)
-                        max = count;
-
-                    iteration++;
-                }
-
-                at(l) = max;
+                at(l + 1) = k;
             }
         }
     };
 
+    // Horspool's shift for each byte value: how far the pattern moves when
+    // {c} is the text character under its last one, m - 1 - the last
+    // position of {c} in pattern[0, m - 1), or m if it is not there
     class BMHTable :
         public std::vector < unsigned int >
     {
     public:
-        BMHTable(std::string pattern) :
-            std::vector < unsigned int >(0xFF)
+        enum
         {
-            for (std::vector < unsigned int >::iterator i = begin(); i != end(); i++) *i = pattern.length();
+            ALPHABET = 256
+        };
 
-            unsigned int i = 1;
-            for (std::string::iterator c  = pattern.begin(); c != pattern.end(); c++)
-            {
-                at(static_cast<unsigned int>(*c)) = i++;
-            }
+        BMHTable(tools::StringView pattern) :
+            std::vector < unsigned int >(ALPHABET, (unsigned int)pattern.size())
+        {
+            for (unsigned int i = 0; i + 1 < pattern.size(); i++)
+                at(static_cast<unsigned char>(pattern[i])) = (unsigned int)pattern.size() - 1 - i;
         }
     };
 
-    static void print(std::string str, std::string pattern, unsigned int offset)
+    inline void print(std::string str, std::string pattern, unsigned int offset)
     {
         std::cout
             << str << "\n"
@@ -18,22 +18,22 @@ int main(int argc, char *argv[])
 
     tools::Reader reader(argv[1]);
 
-    string line;
+    tools::StringView line;
     size_t line_id;
     unsigned int offset = 0;
     while (reader.getLine(line, line_id))
     {
-        vector<string> tokens = tools::split(line, "->");
+        tools::StringView tokens[2];
 
-        if (tokens.size() < 2)
+        if (tools::split(line, "->", tokens, 2) < 2)
         {
             cout << " Skipping line " << line_id << endl;
             continue;
         }
 
         string
-            str = tokens[1],
-            pattern = tokens[0];
+            str = tokens[1].str(),
+            pattern = tokens[0].str();
 
         cout << "\n\nNaive matching:\n===================================================\n\n";
         {
@@ -126,7 +126,7 @@ int main(int argc, char *argv[])
                 {
                     // 3B) The character didn't match, increase the offset
                     // Hint:
-                    // Use the table to know how much to increment the offset: unsigned char increment = table.at(str.at(j));
+                    // Use the table to know how much to increment the offset: unsigned int increment = table.at((unsigned char)str.at(offset + m - 1));
                     // 4) Reset indices
                     i = m - 1;
                     j = i + offset;